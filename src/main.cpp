@@ -1,5 +1,7 @@
+#include "film.hpp"
 #include "integrator.hpp"
 #include "scene_factory.hpp"
+#include "util/parallel.hpp"
 
 #include <spdlog/spdlog.h>
 #include <argparse/argparse.hpp>
@@ -13,11 +15,100 @@ int main(int argc, char** argv) {
   argparse::ArgumentParser program(*argv);
   program.add_argument("scene_file").required();
   program.add_argument("-o", "--output")
-      .help("specify the output file.")
+      .help("specify the output file: .exr, .pfm, .ppm or .png.")
       .default_value("output.ppm");
-  program.add_argument("--spp").scan<'d', int>().default_value(32);
+  program.add_argument("--spp").scan<'d', int>().default_value(
+      RenderOptions().spp);
+  program.add_argument("--noise_threshold")
+      .help(
+          "adaptive sampling: stop sampling a pixel once its relative error "
+          "drops below this, 0 to always take --spp samples.")
+      .scan<'g', Float>()
+      .default_value(RenderOptions().noise_threshold);
+  program.add_argument("--min_spp")
+      .help("adaptive sampling: samples every pixel takes before stopping.")
+      .scan<'d', int>()
+      .default_value(RenderOptions().min_spp);
+  program.add_argument("--spp_image")
+      .help("write the number of samples taken per pixel to this file.")
+      .default_value(std::string());
+  program.add_argument("--time_limit")
+      .help(
+          "render in passes for this many seconds instead of taking --spp "
+          "samples, 0 to disable.")
+      .scan<'g', Float>()
+      .default_value(RenderOptions().time_limit);
+  program.add_argument("--snapshot_interval")
+      .help("write the image so far every this many seconds, 0 to disable.")
+      .scan<'g', Float>()
+      .default_value(RenderOptions().snapshot_interval);
+  program.add_argument("--pass_spp")
+      .help("samples per pixel of each pass of a progressive render.")
+      .scan<'d', int>()
+      .default_value(RenderOptions().pass_spp);
+  program.add_argument("--checkpoint")
+      .help("save the render state to this file now and then, and when done.")
+      .default_value(std::string());
+  program.add_argument("--checkpoint_interval")
+      .help("seconds between checkpoints.")
+      .scan<'g', Float>()
+      .default_value(RenderOptions().checkpoint_interval);
+  program.add_argument("--resume")
+      .help("continue the render saved in this checkpoint, up to --spp.")
+      .default_value(std::string());
+  program.add_argument("--aovs")
+      .help(
+          "also write albedo, normal, depth, primitive and material ids and "
+          "sample counts as layers of the output, which must be an .exr.")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--denoise")
+      .help("filter the image guided by the albedo, normal and depth AOVs.")
+      .default_value(false)
+      .implicit_value(true);
   program.add_argument("--max_depth").scan<'d', int>().default_value(64);
   program.add_argument("--no_mis").default_value(false).implicit_value(true);
+  program.add_argument("--wavefront")
+      .help("trace the samples of each tile together, one bounce at a time.")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--bvh")
+      .help("BVH split method, 'sah' or 'median'.")
+      .default_value(std::string("sah"));
+  program.add_argument("--bvh_bins")
+      .help("number of SAH bins per axis.")
+      .scan<'d', int>()
+      .default_value(16);
+  program.add_argument("--bvh_leaf_size")
+      .help("maximum number of primitives in a BVH leaf.")
+      .scan<'d', int>()
+      .default_value(4);
+  program.add_argument("--bvh_width")
+      .help("BVH node width, 2 or 4 (4 tests child boxes with SIMD).")
+      .scan<'d', int>()
+      .default_value(BVTOptions().width);
+  program.add_argument("--threads")
+      .help("number of worker threads, 0 for one per hardware thread.")
+      .scan<'d', int>()
+      .default_value(0);
+  program.add_argument("--tile_size")
+      .help("edge length in pixels of the tiles handed to render threads.")
+      .scan<'d', int>()
+      .default_value(RenderOptions().tile_size);
+  program.add_argument("--tile_order")
+      .help("order tiles are rendered in, 'scanline', 'spiral' or 'hilbert'.")
+      .default_value(std::string("scanline"));
+  program.add_argument("--sampler")
+      .help(
+          "sample generator, 'independent', 'stratified', 'halton' or "
+          "'sobol'.")
+      .default_value(std::string("sobol"));
+  program.add_argument("--light_sampler")
+      .help(
+          "how shadow rays pick a light, 'uniform', 'power' (in proportion "
+          "to emitted power) or 'bvh' (by estimated contribution, through a "
+          "light hierarchy).")
+      .default_value(std::string("bvh"));
 
   try {
     program.parse_args(argc, argv);
@@ -26,12 +117,91 @@ int main(int argc, char** argv) {
     std::exit(EXIT_FAILURE);
   }
 
+  BVTOptions bvt_opt;
+  bvt_opt.bin_count = program.get<int>("--bvh_bins");
+  bvt_opt.max_leaf_size = program.get<int>("--bvh_leaf_size");
+  bvt_opt.width = program.get<int>("--bvh_width");
+  if (bvt_opt.width != 2 && bvt_opt.width != 4) {
+    std::cerr << "BVH width must be 2 or 4\n" << program;
+    std::exit(EXIT_FAILURE);
+  }
+  if (const auto method = program.get<std::string>("--bvh"); method == "sah")
+    bvt_opt.split_method = SplitMethod::SAH;
+  else if (method == "median")
+    bvt_opt.split_method = SplitMethod::Median;
+  else {
+    std::cerr << "unknown BVH split method: " << method << '\n' << program;
+    std::exit(EXIT_FAILURE);
+  }
+
+  const int threads = program.get<int>("--threads");
+  if (threads < 0) {
+    std::cerr << "thread count must not be negative\n" << program;
+    std::exit(EXIT_FAILURE);
+  }
+  SetNumThreads(threads);
+
+  RenderOptions render_opt;
+  render_opt.spp = program.get<int>("--spp");
+  render_opt.noise_threshold = program.get<Float>("--noise_threshold");
+  render_opt.min_spp = program.get<int>("--min_spp");
+  render_opt.spp_image = program.get<std::string>("--spp_image");
+  render_opt.wavefront = program.get<bool>("--wavefront");
+  render_opt.aovs = program.get<bool>("--aovs");
+  render_opt.denoise = program.get<bool>("--denoise");
+  render_opt.time_limit = program.get<Float>("--time_limit");
+  render_opt.snapshot_interval = program.get<Float>("--snapshot_interval");
+  render_opt.pass_spp = program.get<int>("--pass_spp");
+  render_opt.checkpoint = program.get<std::string>("--checkpoint");
+  render_opt.checkpoint_interval = program.get<Float>("--checkpoint_interval");
+  render_opt.resume = program.get<std::string>("--resume");
+  if (render_opt.time_limit < 0 || render_opt.snapshot_interval < 0 ||
+      render_opt.checkpoint_interval < 0 || render_opt.pass_spp <= 0) {
+    std::cerr << "time limit and intervals must not be negative and pass spp "
+                 "must be positive\n"
+              << program;
+    std::exit(EXIT_FAILURE);
+  }
+  if (render_opt.spp <= 0) {
+    std::cerr << "spp must be positive\n" << program;
+    std::exit(EXIT_FAILURE);
+  }
+  if (render_opt.noise_threshold < 0 || render_opt.min_spp <= 0) {
+    std::cerr << "noise threshold must not be negative and min spp must be "
+                 "positive\n"
+              << program;
+    std::exit(EXIT_FAILURE);
+  }
+  render_opt.tile_size = program.get<int>("--tile_size");
+  if (render_opt.tile_size <= 0) {
+    std::cerr << "tile size must be positive\n" << program;
+    std::exit(EXIT_FAILURE);
+  }
+  LightSamplerType light_sampler;
+  try {
+    render_opt.tile_order =
+        ParseTileOrder(program.get<std::string>("--tile_order"));
+    render_opt.sampler =
+        ParseSamplerType(program.get<std::string>("--sampler"));
+    light_sampler =
+        ParseLightSamplerType(program.get<std::string>("--light_sampler"));
+    const ImageFormat format =
+        ImageFormatFromPath(program.get<std::string>("--output"));
+    if (render_opt.aovs && format != ImageFormat::Exr)
+      throw std::runtime_error("--aovs needs an .exr output");
+    if (!render_opt.spp_image.empty())
+      ImageFormatFromPath(render_opt.spp_image);
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << '\n' << program;
+    std::exit(EXIT_FAILURE);
+  }
+
   // build scene
   SceneFactory factory =
       SceneFactory::FromFile(program.get<std::string>("scene_file"));
 
   Camera camera = factory.CreateCamera();
-  Scene scene = factory.CreateScene();
+  Scene scene = factory.CreateScene(bvt_opt);
 
   spdlog::info("scene setup complete.");
 
@@ -41,9 +211,8 @@ int main(int argc, char** argv) {
   // render
   auto begin_time = chr::high_resolution_clock::now();
   Integrator integrator(scene, program.get<int>("--max_depth"),
-                        !program.get<bool>("--no_mis"));
-  integrator.Render(camera, program.get<std::string>("--output"),
-                    program.get<int>("--spp"));
+                        !program.get<bool>("--no_mis"), light_sampler);
+  integrator.Render(camera, program.get<std::string>("--output"), render_opt);
   auto end_time = chr::high_resolution_clock::now();
   auto duration = chr::duration_cast<chr::seconds>(end_time - begin_time);
   spdlog::info("time wasted rendering: " +
@@ -1,100 +1,686 @@
 #include "aggregator.hpp"
 
+#include "util/parallel.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <mutex>
+
+#ifdef ENABLE_SIMD
+#include <immintrin.h>
+#endif
+
 // ---------- local helper ----------------------------------------------------
 namespace {
+// Past this depth SAH splits are abandoned for median ones, which bounds the
+// tree depth (and the build recursion) on pathological inputs.
+constexpr int kMaxSahDepth = 64;
+
+// Traversal pushes at most one node per level; median splits below
+// kMaxSahDepth add at most 32 more levels for 32-bit primitive counts.
+constexpr int kStackSize = 128;
+static_assert(kStackSize >= kMaxSahDepth + 32);
+
+// Ranges shorter than twice this many primitives are processed on the
+// calling thread.
+constexpr size_t kParallelGrain = 16 * 1024;
+
+// float conversions that never shrink a box
+float RoundDown(Float v) {
+  float f = static_cast<float>(v);
+  return f > v ? std::nextafter(f, -std::numeric_limits<float>::infinity())
+               : f;
+}
+float RoundUp(Float v) {
+  float f = static_cast<float>(v);
+  return f < v ? std::nextafter(f, std::numeric_limits<float>::infinity())
+               : f;
+}
+
+Float SurfaceArea(const float (&bounds)[2][3]) {
+  const Float dx = bounds[1][0] - bounds[0][0],
+              dy = bounds[1][1] - bounds[0][1],
+              dz = bounds[1][2] - bounds[0][2];
+  return 2 * (dx * dy + dy * dz + dz * dx);
+}
+
+// Branchless slab test returning the parametric distance at which `r` enters
+// the box `bounds` within `ray_t`. Near and far planes are picked by the
+// direction signs. NaN slabs (origin on a plane of a parallel ray) leave
+// ray_t as is.
+bool IntersectBox(const float (&bounds)[2][3],
+                  const TraversalRay& r,
+                  Interval<Float> ray_t,
+                  Float& t_enter) {
+  for (int a = 0; a < 3; ++a) {
+    const Float t0 = (bounds[r.sign[a]][a] - r.origin[a]) * r.inv_dir[a];
+    const Float t1 = (bounds[1 - r.sign[a]][a] - r.origin[a]) * r.inv_dir[a];
+    ray_t.begin = t0 > ray_t.begin ? t0 : ray_t.begin;
+    ray_t.end = t1 < ray_t.end ? t1 : ray_t.end;
+  }
+
+  t_enter = ray_t.begin;
+  return ray_t.begin < ray_t.end;
+}
+
+// Tests the ray against all four lanes of a wide node's SoA bounds. Returns a
+// bitmask of the lanes hit within `ray_t`, and their entry distances.
+template <typename WideNode>
+int IntersectLanes(const WideNode& node,
+                   const TraversalRay& r,
+                   const Interval<Float>& ray_t,
+                   Float (&t_enter)[4]) {
+#if defined(ENABLE_SIMD) && defined(__AVX__)
+  __m256d tmin = _mm256_set1_pd(ray_t.begin);
+  __m256d tmax = _mm256_set1_pd(ray_t.end);
+  for (int a = 0; a < 3; ++a) {
+    const __m256d o = _mm256_set1_pd(r.origin[a]);
+    const __m256d inv = _mm256_set1_pd(r.inv_dir[a]);
+    const __m256d lo =
+        _mm256_cvtps_pd(_mm_load_ps(node.bounds[r.sign[a]][a]));
+    const __m256d hi =
+        _mm256_cvtps_pd(_mm_load_ps(node.bounds[1 - r.sign[a]][a]));
+    const __m256d t0 = _mm256_mul_pd(_mm256_sub_pd(lo, o), inv);
+    const __m256d t1 = _mm256_mul_pd(_mm256_sub_pd(hi, o), inv);
+    // max/min return the second operand on NaN, which keeps tmin/tmax
+    tmin = _mm256_max_pd(t0, tmin);
+    tmax = _mm256_min_pd(t1, tmax);
+  }
+  _mm256_storeu_pd(t_enter, tmin);
+  return _mm256_movemask_pd(_mm256_cmp_pd(tmin, tmax, _CMP_LT_OQ));
+#else
+  Float tmin[4], tmax[4];
+  for (int i = 0; i < 4; ++i) {
+    tmin[i] = ray_t.begin;
+    tmax[i] = ray_t.end;
+  }
+  for (int a = 0; a < 3; ++a) {
+    const float* lo = node.bounds[r.sign[a]][a];
+    const float* hi = node.bounds[1 - r.sign[a]][a];
+    for (int i = 0; i < 4; ++i) {
+      const Float t0 = (lo[i] - r.origin[a]) * r.inv_dir[a];
+      const Float t1 = (hi[i] - r.origin[a]) * r.inv_dir[a];
+      tmin[i] = t0 > tmin[i] ? t0 : tmin[i];
+      tmax[i] = t1 < tmax[i] ? t1 : tmax[i];
+    }
+  }
+  int mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    t_enter[i] = tmin[i];
+    mask |= (tmin[i] < tmax[i]) << i;
+  }
+  return mask;
+#endif
+}
+
+template <typename T>
 class AxisSorter {
  public:
   explicit AxisSorter(int axis) : axis_(axis) {}
-  bool operator()(const std::shared_ptr<Primitive>& a,
-                  const std::shared_ptr<Primitive>& b) const {
-    return AABB::Componentbased_Comparer(axis_)(a->GetBbox(), b->GetBbox());
+  bool operator()(const T& a, const T& b) const {
+    return AABB::Componentbased_Comparer(axis_)(a.bbox, b.bbox);
   }
 
  private:
   int axis_;
 };
+
+struct Bin {
+  AABB bbox;
+  uint32_t count = 0;
+
+  void Add(const AABB& box) {
+    bbox = count == 0 ? box : AABB(bbox, box);
+    ++count;
+  }
+  void Add(const Bin& rhs) {
+    if (rhs.count == 0)
+      return;
+    bbox = count == 0 ? rhs.bbox : AABB(bbox, rhs.bbox);
+    count += rhs.count;
+  }
+};
 }  // namespace
 
 // ---------- ctor ------------------------------------------------------------
-BVT::BVT(std::vector<std::shared_ptr<Primitive>> primitives)
-    : primitives_(std::move(primitives)) {
+BVT::BVT(std::vector<std::shared_ptr<Primitive>> primitives, BVTOptions opt)
+    : opt_(std::move(opt)), primitives_(std::move(primitives)) {
   if (primitives_.empty())
     return;
+  opt_.bin_count = std::max(opt_.bin_count, 2);
+  opt_.max_leaf_size = std::max(opt_.max_leaf_size, 1);
+
+  // Primitive bounds are queried once; the build only touches this array.
+  std::vector<BuildPrim> prims(primitives_.size());
+  ParallelFor(
+      0, prims.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          prims[i].bbox = primitives_[i]->GetBbox();
+          prims[i].centroid = prims[i].bbox.Centroid();
+          prims[i].index = static_cast<uint32_t>(i);
+        }
+      },
+      kParallelGrain);
 
-  // Full binary tree
-  nodes_.resize(primitives_.size() * 4);
-  Build(/*nodeIdx=*/0,
+  // Subtrees below the top few levels are built as independent tasks, which
+  // keeps every hardware thread busy after the first splits.
+  const int spawn_depth = std::bit_width(NumThreads());
+
+  // A binary tree with n leaves has 2n-1 nodes, and there are at most as
+  // many leaves as primitives
+  nodes_.reserve(2 * prims.size() - 1);
+  Build(prims,
         /*start   =*/0,
-        /*end     =*/static_cast<uint32_t>(primitives_.size()),
-        /*axis    =*/0);
+        /*end     =*/static_cast<uint32_t>(prims.size()),
+        /*depth   =*/0, spawn_depth, nodes_);
+  nodes_.shrink_to_fit();
+  sah_cost_ = ComputeSahCost();
+
+  if (opt_.width == 4) {
+    wide_nodes_.reserve(nodes_.size() / 2 + 1);
+    Collapse(0);
+    wide_nodes_.shrink_to_fit();
+    nodes_ = std::vector<Node>();
+  }
+
+  std::vector<std::shared_ptr<Primitive>> ordered;
+  ordered.reserve(prims.size());
+  for (const auto& it : prims)
+    ordered.emplace_back(std::move(primitives_[it.index]));
+  primitives_ = std::move(ordered);
 }
 
 // ---------- build -----------------------------------------------------------
-void BVT::Build(uint32_t nodeIdx, uint32_t start, uint32_t end, int axis) {
-  Node& node = nodes_[nodeIdx];
+BVT::RangeBounds BVT::ComputeBounds(const std::vector<BuildPrim>& prims,
+                                    uint32_t start,
+                                    uint32_t end,
+                                    bool parallel) {
+  auto reduce = [&](uint32_t begin, uint32_t stop) {
+    RangeBounds rb{prims[begin].bbox, prims[begin].centroid,
+                   prims[begin].centroid};
+    for (uint32_t i = begin + 1; i < stop; ++i) {
+      rb.bbox = AABB(rb.bbox, prims[i].bbox);
+      for (int a = 0; a < 3; ++a) {
+        rb.cmin[a] = std::min(rb.cmin[a], prims[i].centroid[a]);
+        rb.cmax[a] = std::max(rb.cmax[a], prims[i].centroid[a]);
+      }
+    }
+    return rb;
+  };
+
+  if (!parallel || end - start < 2 * kParallelGrain)
+    return reduce(start, end);
 
+  std::mutex mtx;
+  std::optional<RangeBounds> result;
+  ParallelFor(
+      start, end,
+      [&](size_t begin, size_t stop) {
+        RangeBounds rb = reduce(static_cast<uint32_t>(begin),
+                                static_cast<uint32_t>(stop));
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!result) {
+          result = rb;
+          return;
+        }
+        result->bbox = AABB(result->bbox, rb.bbox);
+        for (int a = 0; a < 3; ++a) {
+          result->cmin[a] = std::min(result->cmin[a], rb.cmin[a]);
+          result->cmax[a] = std::max(result->cmax[a], rb.cmax[a]);
+        }
+      },
+      kParallelGrain);
+  return *result;
+}
+
+uint32_t BVT::Build(std::vector<BuildPrim>& prims,
+                    uint32_t start,
+                    uint32_t end,
+                    int depth,
+                    int spawn_depth,
+                    std::vector<Node>& nodes) {
   // Build this node’s bounding box
-  for (uint32_t i = start; i < end; ++i)
-    node.bbox = (i == start) ? primitives_[i]->GetBbox()
-                             : AABB(node.bbox, primitives_[i]->GetBbox());
-
-  uint32_t span = end - start;
-  if (span == 1) {  // ---- leaf ----
-    node.firstPrim = start;
-    node.primCount = 1;
-    return;
+  const bool parallel = depth == 0;
+  const RangeBounds rb = ComputeBounds(prims, start, end, parallel);
+  const AABB& bounds = rb.bbox;
+  if (depth == 0)
+    bbox_ = bounds;
+
+  const uint32_t nodeIdx = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  for (int a = 0; a < 3; ++a) {
+    nodes[nodeIdx].bounds[0][a] = RoundDown(bounds.Axis(a).begin);
+    nodes[nodeIdx].bounds[1][a] = RoundUp(bounds.Axis(a).end);
+  }
+
+  const uint32_t span = end - start;
+  std::optional<uint32_t> mid;
+  if (span > 1) {
+    if (opt_.split_method == SplitMethod::SAH && depth < kMaxSahDepth)
+      mid = PartitionSAH(prims, rb, start, end, parallel);
+    else if (span > static_cast<uint32_t>(opt_.max_leaf_size))
+      mid = PartitionMedian(prims, start, end, depth % 3);
+  }
+
+  if (!mid.has_value()) {  // ---- leaf ----
+    nodes[nodeIdx].offset = start;
+    nodes[nodeIdx].primCount = span;
+    return nodeIdx;
   }
 
   // ---- interior ----
-  uint32_t mid = start + span / 2;
-  std::nth_element(primitives_.begin() + start, primitives_.begin() + mid,
-                   primitives_.begin() + end, AxisSorter(axis));
+  uint32_t rightIdx;
+  if (depth < spawn_depth && span >= 2 * kParallelGrain) {
+    // The right subtree goes to its own node array on another thread, and is
+    // appended after the left one. The two prims ranges are disjoint.
+    auto right = std::async(std::launch::async, [&, mid = *mid] {
+      std::vector<Node> sub;
+      sub.reserve(2 * (end - mid) - 1);
+      Build(prims, mid, end, depth + 1, spawn_depth, sub);
+      return sub;
+    });
+    Build(prims, start, *mid, depth + 1, spawn_depth, nodes);
+    std::vector<Node> sub = right.get();
+
+    rightIdx = static_cast<uint32_t>(nodes.size());
+    for (Node& node : sub)
+      if (node.primCount == 0)
+        node.offset += rightIdx;
+    nodes.insert(nodes.end(), sub.begin(), sub.end());
+  } else {
+    Build(prims, start, *mid, depth + 1, spawn_depth, nodes);
+    rightIdx = Build(prims, *mid, end, depth + 1, spawn_depth, nodes);
+  }
+
+  nodes[nodeIdx].offset = rightIdx;
+  nodes[nodeIdx].primCount = 0;  // mark interior
+  return nodeIdx;
+}
+
+uint32_t BVT::PartitionMedian(std::vector<BuildPrim>& prims,
+                              uint32_t start,
+                              uint32_t end,
+                              int axis) const {
+  uint32_t mid = start + (end - start) / 2;
+  std::nth_element(prims.begin() + start, prims.begin() + mid,
+                   prims.begin() + end, AxisSorter<BuildPrim>(axis));
+  return mid;
+}
+
+std::optional<uint32_t> BVT::PartitionSAH(std::vector<BuildPrim>& prims,
+                                          const RangeBounds& rb,
+                                          uint32_t start,
+                                          uint32_t end,
+                                          bool parallel) const {
+  const uint32_t span = end - start;
+  const bool can_leaf = span <= static_cast<uint32_t>(opt_.max_leaf_size);
+
+  // bounds of the centroids decide the bin layout
+  const Point3& cmin = rb.cmin;
+  const Point3& cmax = rb.cmax;
+
+  int widest = 0;
+  for (int a = 1; a < 3; ++a)
+    if (cmax[a] - cmin[a] > cmax[widest] - cmin[widest])
+      widest = a;
+
+  const Float area = rb.bbox.SurfaceArea();
+  if (!(area > 0) || cmax[widest] <= cmin[widest]) {
+    if (can_leaf)
+      return std::nullopt;
+    return PartitionMedian(prims, start, end, widest);
+  }
+
+  const int nbins = opt_.bin_count;
+  auto bin_of = [&](const BuildPrim& p, int axis) {
+    const Float extent = cmax[axis] - cmin[axis];
+    int b = static_cast<int>(nbins * (p.centroid[axis] - cmin[axis]) / extent);
+    return std::clamp(b, 0, nbins - 1);
+  };
+
+  // bins of all three axes in one pass, split over threads at the root
+  std::vector<Bin> bins(3 * nbins);
+  auto fill_bins = [&](std::vector<Bin>& out, uint32_t begin, uint32_t stop) {
+    for (uint32_t i = begin; i < stop; ++i)
+      for (int axis = 0; axis < 3; ++axis)
+        if (cmax[axis] > cmin[axis])
+          out[axis * nbins + bin_of(prims[i], axis)].Add(prims[i].bbox);
+  };
+  if (!parallel || span < 2 * kParallelGrain)
+    fill_bins(bins, start, end);
+  else {
+    std::mutex mtx;
+    ParallelFor(
+        start, end,
+        [&](size_t begin, size_t stop) {
+          std::vector<Bin> local(3 * nbins);
+          fill_bins(local, static_cast<uint32_t>(begin),
+                    static_cast<uint32_t>(stop));
+          std::lock_guard<std::mutex> lock(mtx);
+          for (int i = 0; i < 3 * nbins; ++i)
+            bins[i].Add(local[i]);
+        },
+        kParallelGrain);
+  }
+
+  Float best_cost = infinity;
+  int best_axis = -1, best_split = -1;  // split after bin `best_split`
+  std::vector<Float> right_cost(nbins);
+
+  for (int axis = 0; axis < 3; ++axis) {
+    if (cmax[axis] <= cmin[axis])
+      continue;
+    const Bin* axis_bins = bins.data() + axis * nbins;
+
+    // sweep from the right, then from the left evaluating each plane
+    Bin acc;
+    for (int i = nbins - 1; i > 0; --i) {
+      acc.Add(axis_bins[i]);
+      right_cost[i] = acc.count == 0 ? 0 : acc.count * acc.bbox.SurfaceArea();
+    }
+    acc = Bin();
+    for (int i = 0; i < nbins - 1; ++i) {
+      acc.Add(axis_bins[i]);
+      if (acc.count == 0 || acc.count == span)
+        continue;
+      const Float cost =
+          opt_.traversal_cost +
+          opt_.intersect_cost *
+              (acc.count * acc.bbox.SurfaceArea() + right_cost[i + 1]) / area;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_split = i;
+      }
+    }
+  }
+
+  // a leaf costs one intersection per primitive and no traversal step
+  if (can_leaf && (best_axis < 0 || opt_.intersect_cost * span <= best_cost))
+    return std::nullopt;
+  if (best_axis < 0)
+    return PartitionMedian(prims, start, end, widest);
 
-  node.primCount = 0;  // mark interior
+  auto it = std::partition(
+      prims.begin() + start, prims.begin() + end,
+      [&](const BuildPrim& p) { return bin_of(p, best_axis) <= best_split; });
+  uint32_t mid = static_cast<uint32_t>(it - prims.begin());
+  if (mid == start || mid == end)
+    return PartitionMedian(prims, start, end, widest);
+  return mid;
+}
+
+Float BVT::ComputeSahCost() const {
+  if (nodes_.empty())
+    return 0;
 
-  uint32_t leftIdx = (nodeIdx << 1) + 1;
-  uint32_t rightIdx = leftIdx + 1;
+  Float cost = 0;
+  for (const auto& node : nodes_) {
+    const Float area = SurfaceArea(node.bounds);
+    cost += node.primCount == 0
+                ? opt_.traversal_cost * area
+                : opt_.intersect_cost * node.primCount * area;
+  }
 
-  Build(leftIdx, start, mid, (axis + 1) % 3);
-  Build(rightIdx, mid, end, (axis + 1) % 3);
+  const Float root_area = SurfaceArea(nodes_.front().bounds);
+  if (!(root_area > 0))
+    return opt_.intersect_cost * primitives_.size();
+  return cost / root_area;
+}
+
+uint32_t BVT::Collapse(uint32_t nodeIdx) {
+  const uint32_t wideIdx = static_cast<uint32_t>(wide_nodes_.size());
+  wide_nodes_.emplace_back();
+
+  // Open up the interior node with the largest surface area until four
+  // children are gathered or only leaves are left.
+  uint32_t lanes[4] = {nodeIdx};
+  int n = 1;
+  for (; n < 4; ++n) {
+    int best = -1;
+    Float best_area = -1;
+    for (int i = 0; i < n; ++i) {
+      const Node& node = nodes_[lanes[i]];
+      if (node.primCount == 0 && SurfaceArea(node.bounds) > best_area) {
+        best = i;
+        best_area = SurfaceArea(node.bounds);
+      }
+    }
+    if (best < 0)
+      break;
+    const uint32_t opened = lanes[best];
+    lanes[best] = opened + 1;
+    lanes[n] = nodes_[opened].offset;
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    WideNode& wide = wide_nodes_[wideIdx];
+    if (i >= n) {
+      for (int a = 0; a < 3; ++a) {
+        wide.bounds[0][a][i] = std::numeric_limits<float>::infinity();
+        wide.bounds[1][a][i] = -std::numeric_limits<float>::infinity();
+      }
+      wide.child[i] = 0;
+      wide.count[i] = kEmptyLane;
+      continue;
+    }
+
+    const Node& node = nodes_[lanes[i]];
+    for (int a = 0; a < 3; ++a) {
+      wide.bounds[0][a][i] = node.bounds[0][a];
+      wide.bounds[1][a][i] = node.bounds[1][a];
+    }
+    wide.count[i] = node.primCount;
+    if (node.primCount > 0)
+      wide.child[i] = node.offset;
+    else {
+      // wide_nodes_ may reallocate, don't keep `wide` across the call
+      const uint32_t child = Collapse(lanes[i]);
+      wide_nodes_[wideIdx].child[i] = child;
+    }
+  }
+
+  return wideIdx;
 }
 
 // ---------- traversal -------------------------------------------------------
 HitRecord BVT::Hit(const Ray& r, const Interval<Float>& time) const {
-  return nodes_.empty() ? HitRecord() : Traverse(0, r, time);
+  const TraversalRay tr(r);
+  if (!wide_nodes_.empty())
+    return TraverseWide(r, tr, time);
+  if (!nodes_.empty())
+    return Traverse(r, tr, time);
+  return HitRecord();
 }
 
-HitRecord BVT::Traverse(uint32_t nodeIdx,
-                        const Ray& r,
+HitRecord BVT::Traverse(const Ray& r,
+                        const TraversalRay& tr,
                         Interval<Float> t) const {
-  if (nodeIdx >= nodes_.size())
-    return HitRecord();
-
-  const Node& node = nodes_[nodeIdx];
-  if (!node.bbox.isHitIn(r, t))
-    return HitRecord();
-
-  // ---- leaf ----
-  if (node.primCount > 0) {
-    HitRecord closest;
-    Float bestT = t.end;
-    for (uint32_t i = 0; i < node.primCount; ++i) {
-      HitRecord tmp = primitives_[node.firstPrim + i]->Hit(r, t);
-      if (tmp.hits && tmp.time < bestT) {
-        bestT = tmp.time;
-        closest = tmp;
+  // t.end shrinks to the closest hit so far, culling everything behind it
+  HitRecord closest;
+  Float t_enter;
+  if (!IntersectBox(nodes_.front().bounds, tr, t, t_enter))
+    return closest;
+
+  struct StackEntry {
+    uint32_t node;
+    Float t_enter;
+  };
+  std::array<StackEntry, kStackSize> stack;
+  int top = 0;
+
+  uint32_t nodeIdx = 0;
+  for (;;) {
+    const Node& node = nodes_[nodeIdx];
+
+    if (node.primCount > 0) {  // ---- leaf ----
+      for (uint32_t i = 0; i < node.primCount; ++i) {
+        HitRecord tmp = primitives_[node.offset + i]->Hit(r, t);
+        if (tmp.hits && tmp.time < t.end) {
+          t.end = tmp.time;
+          closest = tmp;
+        }
+      }
+    } else {  // ---- interior: visit the nearer child first ----
+      uint32_t leftIdx = nodeIdx + 1;
+      uint32_t rightIdx = node.offset;
+
+      Float t_left, t_right;
+      const bool hit_left = IntersectBox(nodes_[leftIdx].bounds, tr, t, t_left);
+      const bool hit_right =
+          IntersectBox(nodes_[rightIdx].bounds, tr, t, t_right);
+
+      if (hit_left && hit_right) {
+        if (t_right < t_left) {
+          std::swap(leftIdx, rightIdx);
+          std::swap(t_left, t_right);
+        }
+        stack[top++] = StackEntry{rightIdx, t_right};
+        nodeIdx = leftIdx;
+        continue;
+      }
+      if (hit_left || hit_right) {
+        nodeIdx = hit_left ? leftIdx : rightIdx;
+        continue;
       }
     }
-    return closest;
+
+    // pop the next node that can still hold a closer hit
+    while (top > 0 && stack[top - 1].t_enter >= t.end)
+      --top;
+    if (top == 0)
+      break;
+    nodeIdx = stack[--top].node;
   }
 
-  // ---- interior ----
-  uint32_t leftIdx = (nodeIdx << 1) + 1;
-  uint32_t rightIdx = leftIdx + 1;
+  return closest;
+}
+
+HitRecord BVT::TraverseWide(const Ray& r,
+                            const TraversalRay& tr,
+                            Interval<Float> t) const {
+  HitRecord closest;
+
+  struct StackEntry {
+    uint32_t index;
+    uint32_t count;  // > 0 for leaves
+    Float t_enter;
+  };
+  // every wide node pushes at most three entries beyond the one it pops
+  std::array<StackEntry, 3 * kStackSize> stack;
+  int top = 0;
+  stack[top++] = StackEntry{0, 0, t.begin};
+
+  while (top > 0) {
+    const StackEntry entry = stack[--top];
+    if (entry.t_enter >= t.end)
+      continue;
+
+    if (entry.count > 0) {  // ---- leaf ----
+      for (uint32_t i = 0; i < entry.count; ++i) {
+        HitRecord tmp = primitives_[entry.index + i]->Hit(r, t);
+        if (tmp.hits && tmp.time < t.end) {
+          t.end = tmp.time;
+          closest = tmp;
+        }
+      }
+      continue;
+    }
+
+    const WideNode& node = wide_nodes_[entry.index];
+    Float t_lane[4];
+    int mask = IntersectLanes(node, tr, t, t_lane);
+
+    // push the hit lanes far to near, so that the nearest is popped first
+    StackEntry hits[4];
+    int n = 0;
+    for (; mask != 0; mask &= mask - 1) {
+      const int lane = std::countr_zero(static_cast<unsigned>(mask));
+      if (node.count[lane] == kEmptyLane)
+        continue;
+      StackEntry e{node.child[lane], node.count[lane], t_lane[lane]};
+      int j = n++;
+      for (; j > 0 && hits[j - 1].t_enter < e.t_enter; --j)
+        hits[j] = hits[j - 1];
+      hits[j] = e;
+    }
+    for (int i = 0; i < n; ++i)
+      stack[top++] = hits[i];
+  }
+
+  return closest;
+}
+
+bool BVT::AnyHit(const Ray& r, const Interval<Float>& time) const {
+  const TraversalRay tr(r);
+  if (!wide_nodes_.empty())
+    return AnyHitWide(r, tr, time);
+  if (!nodes_.empty())
+    return AnyHitBinary(r, tr, time);
+  return false;
+}
+
+bool BVT::AnyHitBinary(const Ray& r,
+                       const TraversalRay& tr,
+                       const Interval<Float>& t) const {
+  Float t_enter;
+  if (!IntersectBox(nodes_.front().bounds, tr, t, t_enter))
+    return false;
+
+  std::array<uint32_t, kStackSize> stack;
+  int top = 0;
+  stack[top++] = 0;
+
+  while (top > 0) {
+    const Node& node = nodes_[stack[--top]];
+
+    if (node.primCount > 0) {  // ---- leaf ----
+      for (uint32_t i = 0; i < node.primCount; ++i)
+        if (primitives_[node.offset + i]->Intersects(r, t))
+          return true;
+      continue;
+    }
+
+    const uint32_t leftIdx = &node - nodes_.data() + 1;
+    if (IntersectBox(nodes_[node.offset].bounds, tr, t, t_enter))
+      stack[top++] = node.offset;
+    if (IntersectBox(nodes_[leftIdx].bounds, tr, t, t_enter))
+      stack[top++] = leftIdx;
+  }
 
-  HitRecord lh = Traverse(leftIdx, r, t);
-  Float cut = lh.hits ? lh.time : t.end;
-  HitRecord rh = Traverse(rightIdx, r, Interval<Float>{t.begin, cut});
+  return false;
+}
+
+bool BVT::AnyHitWide(const Ray& r,
+                     const TraversalRay& tr,
+                     const Interval<Float>& t) const {
+  std::array<uint32_t, 3 * kStackSize> stack;
+  int top = 0;
+  stack[top++] = 0;
+
+  while (top > 0) {
+    const WideNode& node = wide_nodes_[stack[--top]];
+    Float t_lane[4];
+    int mask = IntersectLanes(node, tr, t, t_lane);
+
+    for (; mask != 0; mask &= mask - 1) {
+      const int lane = std::countr_zero(static_cast<unsigned>(mask));
+      const uint32_t count = node.count[lane];
+      if (count == kEmptyLane)
+        continue;
+      if (count == 0) {
+        stack[top++] = node.child[lane];
+        continue;
+      }
+      for (uint32_t i = 0; i < count; ++i)
+        if (primitives_[node.child[lane] + i]->Intersects(r, t))
+          return true;
+    }
+  }
 
-  return rh.hits ? rh : lh;
+  return false;
 }
@@ -7,33 +7,133 @@
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <span>
 #include <stdexcept>
 #include <vector>
 
+enum class SplitMethod { SAH, Median };
+
+struct BVTOptions {
+  SplitMethod split_method = SplitMethod::SAH;
+  int bin_count = 16;  // SAH candidate planes per axis = bin_count - 1
+  int max_leaf_size = 4;
+
+  // SAH cost model, relative costs of one node visit / one primitive test
+  Float traversal_cost = 1.0;
+  Float intersect_cost = 1.0;
+
+  // 2: binary tree, 4: collapse into 4-wide nodes tested in one SIMD pass
+#ifdef ENABLE_SIMD
+  int width = 4;
+#else
+  int width = 2;
+#endif
+};
+
 class BVT {
  public:
-  explicit BVT(std::vector<std::shared_ptr<Primitive>> primitives);
+  explicit BVT(std::vector<std::shared_ptr<Primitive>> primitives,
+               BVTOptions opt = BVTOptions());
 
   HitRecord Hit(const Ray& r, const Interval<Float>& time) const;
-  const AABB& GetBbox() const noexcept { return nodes_.front().bbox; }
+  // Whether any primitive is hit within `time`. Stops at the first
+  // intersection found, in no particular order.
+  bool AnyHit(const Ray& r, const Interval<Float>& time) const;
+  const AABB& GetBbox() const noexcept { return bbox_; }
 
   inline std::span<const std::shared_ptr<Primitive>> GetPrimitives() const {
     return primitives_;
   }
 
+  // Expected cost of a random ray query under the SAH cost model, in units of
+  // `BVTOptions::intersect_cost`/`traversal_cost`, evaluated on the binary
+  // tree. Lower is better.
+  inline Float SahCost() const noexcept { return sah_cost_; }
+  inline size_t NodeCount() const noexcept {
+    return wide_nodes_.empty() ? nodes_.size() : wide_nodes_.size();
+  }
+
  private:
-  struct Node {
-    AABB bbox;           // bounds of this node
-    uint32_t firstPrim;  // offset in primitives_ (valid when primCount>0)
+  // Nodes are stored in depth-first order: the left child of an interior
+  // node immediately follows it, only the right child needs an offset.
+  struct alignas(32) Node {
+    float bounds[2][3];  // min / max corner, rounded outward
+    uint32_t offset;     // leaf: first index in primitives_
+                         // interior: index of the right child
     uint32_t primCount;  // 0 -> interior, >0 -> leaf
   };
+  static_assert(sizeof(Node) == 32);
+
+  // Children of a 4-wide node, with bounds in SoA form so that one SIMD pass
+  // tests all of them. Used lanes come first, unused ones have
+  // count == kEmptyLane.
+  static constexpr uint32_t kEmptyLane = UINT32_MAX;
+  struct alignas(64) WideNode {
+    float bounds[2][3][4];  // [min/max][axis][lane], rounded outward
+    uint32_t child[4];      // leaf: first index in primitives_
+                            // interior: index into wide_nodes_
+    uint32_t count[4];      // primitive count, 0 -> interior
+  };
+  static_assert(sizeof(WideNode) == 128);
+
+  struct BuildPrim {
+    AABB bbox;
+    Point3 centroid;
+    uint32_t index;  // into primitives_
+  };
+
+  struct RangeBounds {
+    AABB bbox;
+    Point3 cmin, cmax;  // bounds of the centroids
+  };
 
-  // recursive build / traversal helpers
-  void Build(uint32_t nodeIdx, uint32_t start, uint32_t end, int axis);
+  // recursive build helpers, Build appends the subtree over prims[start,end)
+  // to `nodes` and returns the index of its root there. Subtrees above
+  // `spawn_depth` are built concurrently. Only the root node splits its own
+  // bounds and binning work over threads, deeper ones already run in parallel.
+  uint32_t Build(std::vector<BuildPrim>& prims,
+                 uint32_t start,
+                 uint32_t end,
+                 int depth,
+                 int spawn_depth,
+                 std::vector<Node>& nodes);
+  static RangeBounds ComputeBounds(const std::vector<BuildPrim>& prims,
+                                   uint32_t start,
+                                   uint32_t end,
+                                   bool parallel);
+  // returns nullopt when a leaf is cheaper than any split
+  std::optional<uint32_t> PartitionSAH(std::vector<BuildPrim>& prims,
+                                       const RangeBounds& rb,
+                                       uint32_t start,
+                                       uint32_t end,
+                                       bool parallel) const;
+  uint32_t PartitionMedian(std::vector<BuildPrim>& prims,
+                           uint32_t start,
+                           uint32_t end,
+                           int axis) const;
+  Float ComputeSahCost() const;
+  // collapses the binary subtree at nodes_[nodeIdx] into wide_nodes_
+  uint32_t Collapse(uint32_t nodeIdx);
 
-  HitRecord Traverse(uint32_t nodeIdx, const Ray& r, Interval<Float> t) const;
+  // `tr` holds the slab test constants of `r`, primitives are hit with `r`
+  HitRecord Traverse(const Ray& r,
+                     const TraversalRay& tr,
+                     Interval<Float> t) const;
+  HitRecord TraverseWide(const Ray& r,
+                         const TraversalRay& tr,
+                         Interval<Float> t) const;
+  bool AnyHitBinary(const Ray& r,
+                    const TraversalRay& tr,
+                    const Interval<Float>& t) const;
+  bool AnyHitWide(const Ray& r,
+                  const TraversalRay& tr,
+                  const Interval<Float>& t) const;
 
-  std::vector<Node> nodes_;  // implicit binary tree
+  BVTOptions opt_;
+  AABB bbox_;                // exact bounds of the whole tree
+  std::vector<Node> nodes_;  // nodes_[0] is the root
+  std::vector<WideNode> wide_nodes_;  // replaces nodes_ when width == 4
+  Float sah_cost_ = 0;
   std::vector<std::shared_ptr<Primitive>> primitives_;
 };
@@ -19,11 +19,13 @@ Color BSDF::f(Vector3 wi, Vector3 wo, BxDFBits flag) const {
   return Color{0, 0, 0};
 }
 
-std::optional<bxdfSample> BSDF::Sample_f(Vector3 wi) const {
+std::optional<bxdfSample> BSDF::Sample_f(Vector3 wi,
+                                         Float uc,
+                                         Point2 u) const {
   if (!bxdf_)
     return std::nullopt;
 
-  auto sample_opt = bxdf_->Sample_f(transform.Doit(wi).Normalized());
+  auto sample_opt = bxdf_->Sample_f(transform.Doit(wi).Normalized(), uc, u);
   if (!sample_opt)
     return std::nullopt;
 
@@ -51,8 +51,11 @@ class BxDF {
   virtual Color f(const Vector3& wi, const Vector3& wo) const = 0;
 
   // a method that uses importance sampling to draw a direction from a
-  // distribution that approximately matches the scattering function's shape
-  virtual std::optional<bxdfSample> Sample_f(const Vector3& wi) const = 0;
+  // distribution that approximately matches the scattering function's shape.
+  // `uc` picks among lobes, `u` places the direction within the lobe.
+  virtual std::optional<bxdfSample> Sample_f(const Vector3& wi,
+                                             Float uc,
+                                             Point2 u) const = 0;
 
   // returns the value of the probability density function for the given pair of
   // directions
@@ -81,7 +84,7 @@ class BSDF {
   explicit BSDF(std::shared_ptr<BxDF> bxdf, QuaternionTransform trans);
 
   Color f(Vector3 wi, Vector3 wo, BxDFBits flag = BxDFBits::All) const;
-  std::optional<bxdfSample> Sample_f(Vector3 wi) const;
+  std::optional<bxdfSample> Sample_f(Vector3 wi, Float uc, Point2 u) const;
   Float pdf(Vector3 wi, Vector3 wo, BxDFBits flag = BxDFBits::All) const;
   bool MatchesFlag(BxDFBits flag) const;
 
@@ -53,7 +53,9 @@ Float Conductor::pdf(const Vector3& wi, const Vector3& wo) const {
   return mfdist_.PDF(wi, wm) / (4 * std::abs(wo.Dot(wm)));
 }
 
-std::optional<bxdfSample> Conductor::Sample_f(const Vector3& wi) const {
+std::optional<bxdfSample> Conductor::Sample_f(const Vector3& wi,
+                                              Float,
+                                              Point2 u) const {
   if (mfdist_.EffectivelySmooth()) {
     // Perfect mirror: reflect across the normal
     Vector3 wo(wi.x(), -wi.y(), wi.z());
@@ -64,7 +66,7 @@ std::optional<bxdfSample> Conductor::Sample_f(const Vector3& wi) const {
     return std::nullopt;
 
   // Sample microfacet normal and reflect about it
-  Vector3 wm = mfdist_.Sample_wm(-wi);
+  Vector3 wm = mfdist_.Sample_wm(-wi, u);
   Vector3 wo = Reflect(wi, wm);
   if (!SameHemisphere(wi, wo))
     return std::nullopt;
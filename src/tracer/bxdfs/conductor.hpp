@@ -42,7 +42,9 @@ class Conductor : public BxDF {
   /**
    * Sample an outgoing direction according to the microfacet distribution.
    */
-  std::optional<bxdfSample> Sample_f(const Vector3& wi) const override;
+  std::optional<bxdfSample> Sample_f(const Vector3& wi,
+                                     Float uc,
+                                     Point2 u) const override;
 
   /**
    * PDF for sampling \c wo given \c wi.
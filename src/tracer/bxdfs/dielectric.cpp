@@ -112,7 +112,9 @@ Float Dielectric::pdf(const Vector3& wi, const Vector3& wo) const {
   return pdf;
 }
 
-std::optional<bxdfSample> Dielectric::Sample_f(const Vector3& wi) const {
+std::optional<bxdfSample> Dielectric::Sample_f(const Vector3& wi,
+                                               Float uc,
+                                               Point2 u) const {
   // Determine if the ray is entering or exiting
   bool entering = wi.y() < 0;
   Float etaI = entering ? 1.0 : eta;
@@ -123,7 +125,7 @@ std::optional<bxdfSample> Dielectric::Sample_f(const Vector3& wi) const {
     Float pr = FrDielectric(CosTheta(-wi), eta);
     Float pt = 1 - pr;
 
-    if (random_uniform_01() < pr) {
+    if (uc < pr) {
       // Specular reflection
       Vector3 wo(wi.x(), -wi.y(), wi.z());
       Color fr(pr / AbsCosTheta(wo));
@@ -142,11 +144,11 @@ std::optional<bxdfSample> Dielectric::Sample_f(const Vector3& wi) const {
     }
   } else {
     // Sample a microfacet normal for rough surfaces
-    Vector3 wm = mfdist_.Sample_wm(-wi);
+    Vector3 wm = mfdist_.Sample_wm(-wi, u);
     Float pr = FrDielectric(wm.Dot(-wi), eta);
     Float pt = 1.0 - pr;
 
-    if (random_uniform_01() < pr) {
+    if (uc < pr) {
       // Reflect about the sampled microfacet normal
       Vector3 wo = Reflect(wi, wm).Normalized();
       if (!SameHemisphere(wi, wo))
@@ -35,7 +35,9 @@ class Dielectric : public BxDF {
   Color f(const Vector3& wi, const Vector3& wo) const override;
 
   /// Importance sample an outgoing direction.
-  std::optional<bxdfSample> Sample_f(const Vector3& wi) const override;
+  std::optional<bxdfSample> Sample_f(const Vector3& wi,
+                                     Float uc,
+                                     Point2 u) const override;
 
   /// PDF of sampling \c wo given \c wi.
   Float pdf(const Vector3& wi, const Vector3& wo) const override;
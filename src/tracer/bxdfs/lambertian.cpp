@@ -17,9 +17,11 @@ Color Lambertian::f(const Vector3& wi, const Vector3& wo) const {
   return SameHemisphere(wi, wo) ? col * invpi : Color(0, 0, 0);
 }
 
-std::optional<bxdfSample> Lambertian::Sample_f(const Vector3& wi) const {
+std::optional<bxdfSample> Lambertian::Sample_f(const Vector3& wi,
+                                               Float,
+                                               Point2 u) const {
   // Sample wo ~ cos(theta)/pi
-  auto wo = Spawn_cosine_distributed_hemisphere();
+  auto wo = Spawn_cosine_distributed_hemisphere(u);
   wo.y() *= wi.y() > 0 ? -1 : 1;
   return bxdfSample(col * invpi, wo, pdf(wi, wo),
                     BxDFBits::Diffuse | BxDFBits::Reflection);
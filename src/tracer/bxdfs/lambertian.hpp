@@ -67,7 +67,9 @@ class Lambertian : public BxDF {
    *   - \c pdf: probability density of \c wo;
    *   - \c bxdf: pointer to this BRDF instance.
    */
-  std::optional<bxdfSample> Sample_f(const Vector3& wi) const override;
+  std::optional<bxdfSample> Sample_f(const Vector3& wi,
+                                     Float uc,
+                                     Point2 u) const override;
 
   /**
    * @brief Compute the PDF of sampling \c wo given \c wi.
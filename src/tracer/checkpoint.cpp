@@ -0,0 +1,247 @@
+#include "checkpoint.hpp"
+
+#include "integrator.hpp"
+#include "primitive.hpp"
+
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+SceneIds::SceneIds(std::span<const std::shared_ptr<Primitive>> primitives) {
+  for (const auto& prim : primitives) {
+    primitives_.push_back(prim.get());
+    primitive_ids_.emplace(prim.get(), primitives_.size());
+    const IMaterial* mat = prim->GetMaterial().get();
+    if (mat && material_ids_.emplace(mat, materials_.size() + 1).second)
+      materials_.push_back(mat);
+  }
+}
+
+uint32_t SceneIds::Id(const Primitive* primitive) const {
+  return primitive ? primitive_ids_.at(primitive) : 0;
+}
+
+uint32_t SceneIds::Id(const IMaterial* material) const {
+  return material ? material_ids_.at(material) : 0;
+}
+
+const Primitive* SceneIds::GetPrimitive(uint32_t id) const {
+  if (id > primitives_.size())
+    throw std::runtime_error(std::format("unknown primitive id {}", id));
+  return id ? primitives_[id - 1] : nullptr;
+}
+
+const IMaterial* SceneIds::GetMaterial(uint32_t id) const {
+  if (id > materials_.size())
+    throw std::runtime_error(std::format("unknown material id {}", id));
+  return id ? materials_[id - 1] : nullptr;
+}
+
+void AovAccumulator::Add(const FirstHit& hit) {
+  if (samples++ == 0) {
+    primitive = hit.primitive;
+    material = hit.material;
+  }
+  if (!hit.primitive)
+    return;
+  albedo += hit.albedo;
+  normal += hit.normal;
+  distance += hit.distance;
+  ++hits;
+}
+
+namespace {
+constexpr char kMagic[8] = {'P', 'R', 'S', 'M', 'C', 'K', 'P', 'T'};
+constexpr uint32_t kVersion = 2;
+
+class Writer {
+ public:
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  void Put(const T& v) {
+    const char* p = reinterpret_cast<const char*>(&v);
+    buf_.insert(buf_.end(), p, p + sizeof(T));
+  }
+  const std::vector<char>& Buffer() const { return buf_; }
+
+ private:
+  std::vector<char> buf_;
+};
+
+class Reader {
+ public:
+  Reader(const std::string& data, const std::filesystem::path& path)
+      : data_(data), path_(path) {}
+
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  T Get() {
+    if (data_.size() - pos_ < sizeof(T))
+      throw std::runtime_error(
+          std::format("{}: truncated checkpoint", path_.string()));
+    T v;
+    std::memcpy(&v, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return v;
+  }
+  bool AtEnd() const { return pos_ == data_.size(); }
+
+ private:
+  const std::string& data_;
+  const std::filesystem::path& path_;
+  size_t pos_ = 0;
+};
+
+template <typename V>
+void PutVector(Writer& w, const V& v) {
+  for (int i = 0; i < 3; ++i)
+    w.Put<Float>(v[i]);
+}
+}  // namespace
+
+void WriteCheckpoint(const std::filesystem::path& path,
+                     const Checkpoint& ck,
+                     const SceneIds& ids) {
+  Writer w;
+  w.Put(kMagic);
+  w.Put(kVersion);
+  w.Put(static_cast<uint32_t>(sizeof(Float)));
+  w.Put<int32_t>(ck.width);
+  w.Put<int32_t>(ck.height);
+  w.Put(static_cast<uint32_t>(ck.sampler));
+  w.Put<int32_t>(ck.sampler_spp);
+  w.Put<uint64_t>(ck.seed);
+  w.Put<int32_t>(ck.spp);
+  w.Put<Float>(ck.noise_threshold);
+  w.Put<uint8_t>(ck.aovs);
+
+  // one array per field
+  for (const PixelState& px : ck.pixels)
+    PutVector(w, px.sum);
+  for (const PixelState& px : ck.pixels)
+    w.Put<int32_t>(px.n);
+  for (const PixelState& px : ck.pixels)
+    w.Put<Float>(px.mean);
+  for (const PixelState& px : ck.pixels)
+    w.Put<Float>(px.m2);
+  for (const PixelState& px : ck.pixels)
+    w.Put<uint8_t>(px.converged);
+  if (ck.aovs) {
+    for (const PixelState& px : ck.pixels)
+      w.Put<uint32_t>(ids.Id(px.aov.primitive));
+    for (const PixelState& px : ck.pixels)
+      w.Put<uint32_t>(ids.Id(px.aov.material));
+    for (const PixelState& px : ck.pixels)
+      PutVector(w, px.aov.albedo);
+    for (const PixelState& px : ck.pixels)
+      PutVector(w, px.aov.normal);
+    for (const PixelState& px : ck.pixels)
+      w.Put<Float>(px.aov.distance);
+    for (const PixelState& px : ck.pixels)
+      w.Put<int32_t>(px.aov.hits);
+    for (const PixelState& px : ck.pixels)
+      w.Put<int32_t>(px.aov.samples);
+  }
+
+  std::filesystem::path tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(w.Buffer().data(), w.Buffer().size());
+    if (!out)
+      throw std::runtime_error(std::format("{}: write failed", tmp.string()));
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec)
+    throw std::runtime_error(
+        std::format("{}: {}", path.string(), ec.message()));
+}
+
+Checkpoint ReadCheckpoint(const std::filesystem::path& path,
+                          const SceneIds& ids) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error(std::format("{}: cannot open", path.string()));
+  const std::string data{std::istreambuf_iterator<char>(in), {}};
+  Reader r(data, path);
+
+  char magic[8];
+  for (char& c : magic)
+    c = r.Get<char>();
+  if (std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+    throw std::runtime_error(
+        std::format("{}: not a checkpoint", path.string()));
+  if (const uint32_t version = r.Get<uint32_t>(); version != kVersion)
+    throw std::runtime_error(std::format(
+        "{}: unsupported checkpoint version {}", path.string(), version));
+  if (r.Get<uint32_t>() != sizeof(Float))
+    throw std::runtime_error(std::format(
+        "{}: written with a different floating point type", path.string()));
+
+  Checkpoint ck;
+  ck.width = r.Get<int32_t>();
+  ck.height = r.Get<int32_t>();
+  const uint32_t sampler = r.Get<uint32_t>();
+  if (sampler > static_cast<uint32_t>(SamplerType::Sobol))
+    throw std::runtime_error(
+        std::format("{}: unknown sampler {}", path.string(), sampler));
+  ck.sampler = static_cast<SamplerType>(sampler);
+  ck.sampler_spp = r.Get<int32_t>();
+  ck.seed = r.Get<uint64_t>();
+  ck.spp = r.Get<int32_t>();
+  ck.noise_threshold = r.Get<Float>();
+  ck.aovs = r.Get<uint8_t>();
+  // every pixel takes more than a byte, which bounds the allocation below
+  if (ck.width <= 0 || ck.height <= 0 || ck.sampler_spp <= 0 ||
+      size_t(ck.width) * ck.height > data.size())
+    throw std::runtime_error(
+        std::format("{}: corrupt checkpoint header", path.string()));
+
+  auto get_vector = [&]() {
+    const Float x = r.Get<Float>(), y = r.Get<Float>();
+    return std::array<Float, 3>{x, y, r.Get<Float>()};
+  };
+  ck.pixels.resize(size_t(ck.width) * ck.height);
+  for (PixelState& px : ck.pixels) {
+    const auto v = get_vector();
+    px.sum = Color(v[0], v[1], v[2]);
+  }
+  for (PixelState& px : ck.pixels)
+    px.n = r.Get<int32_t>();
+  for (PixelState& px : ck.pixels)
+    px.mean = r.Get<Float>();
+  for (PixelState& px : ck.pixels)
+    px.m2 = r.Get<Float>();
+  for (PixelState& px : ck.pixels)
+    px.converged = r.Get<uint8_t>();
+  if (ck.aovs) {
+    for (PixelState& px : ck.pixels)
+      px.aov.primitive = ids.GetPrimitive(r.Get<uint32_t>());
+    for (PixelState& px : ck.pixels)
+      px.aov.material = ids.GetMaterial(r.Get<uint32_t>());
+    for (PixelState& px : ck.pixels) {
+      const auto v = get_vector();
+      px.aov.albedo = Color(v[0], v[1], v[2]);
+    }
+    for (PixelState& px : ck.pixels) {
+      const auto v = get_vector();
+      px.aov.normal = Vector3(v[0], v[1], v[2]);
+    }
+    for (PixelState& px : ck.pixels)
+      px.aov.distance = r.Get<Float>();
+    for (PixelState& px : ck.pixels)
+      px.aov.hits = r.Get<int32_t>();
+    for (PixelState& px : ck.pixels)
+      px.aov.samples = r.Get<int32_t>();
+  }
+  if (!r.AtEnd())
+    throw std::runtime_error(
+        std::format("{}: trailing data in checkpoint", path.string()));
+  return ck;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "sampler.hpp"
+#include "util/util.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class IMaterial;
+class Primitive;
+struct FirstHit;
+
+// Ids of the primitives and materials of a scene, as the AOVs and
+// checkpoints store them. Both count from 1 in the order the primitives are
+// listed, materials by first appearance; 0 stands for none.
+class SceneIds {
+ public:
+  explicit SceneIds(std::span<const std::shared_ptr<Primitive>> primitives);
+
+  uint32_t Id(const Primitive* primitive) const;
+  uint32_t Id(const IMaterial* material) const;
+  // Throw std::runtime_error on an unknown id.
+  const Primitive* GetPrimitive(uint32_t id) const;
+  const IMaterial* GetMaterial(uint32_t id) const;
+
+ private:
+  std::vector<const Primitive*> primitives_;
+  std::vector<const IMaterial*> materials_;
+  std::unordered_map<const Primitive*, uint32_t> primitive_ids_;
+  std::unordered_map<const IMaterial*, uint32_t> material_ids_;
+};
+
+// Sums the first hits of the samples of a pixel for its AOVs.
+struct AovAccumulator {
+  void Add(const FirstHit& hit);
+
+  // of sample 0, gives the ids
+  const Primitive* primitive = nullptr;
+  const IMaterial* material = nullptr;
+  Color albedo = Color(0);
+  Vector3 normal = Vector3(0, 0, 0);
+  Float distance = 0;
+  int hits = 0, samples = 0;
+};
+
+// What a pixel has gathered so far, kept across passes and checkpoints.
+struct PixelState {
+  Color sum = Color(0);
+  int n = 0;
+  // running mean and variance of the luminance (Welford)
+  Float mean = 0, m2 = 0;
+  bool converged = false;
+  AovAccumulator aov;
+};
+
+/**
+ * Checkpoint
+ * ----------
+ * Everything needed to continue a render: the per-pixel sums and sample
+ * counts, and the sampler they were drawn from. Samples are pure functions of
+ * (pixel, sample index, dimension, seed), so a resumed render takes exactly
+ * the samples it would have taken without the interruption.
+ *
+ * Stored as a small header followed by each per-pixel field as one binary
+ * array in native byte order.
+ */
+struct Checkpoint {
+  int width = 0, height = 0;
+  SamplerType sampler = SamplerType::Sobol;
+  int sampler_spp = 0;  // the sampler's samples per pixel
+  uint64_t seed = 0;
+  int spp = 0;  // samples per pixel the passes so far asked for
+  // of adaptive sampling, which set the pixels' converged flags; 0 if off
+  Float noise_threshold = 0;
+  bool aovs = false;
+  std::vector<PixelState> pixels;
+};
+
+// Writes to a temporary file next to `path` first and renames it, so an
+// interrupted write leaves the previous checkpoint intact. Throws
+// std::runtime_error on failure.
+void WriteCheckpoint(const std::filesystem::path& path,
+                     const Checkpoint& checkpoint,
+                     const SceneIds& ids);
+// Throws std::runtime_error if `path` is not a checkpoint or cannot be read.
+Checkpoint ReadCheckpoint(const std::filesystem::path& path,
+                          const SceneIds& ids);
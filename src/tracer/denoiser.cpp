@@ -0,0 +1,261 @@
+#include "denoiser.hpp"
+
+#include "util/parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+#if defined(ENABLE_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+// B3-spline taps
+constexpr float kKernel[5] = {1 / 16.f, 1 / 4.f, 3 / 8.f, 1 / 4.f, 1 / 16.f};
+// stands in for the infinite depth of background pixels, far enough to stop
+// every tap between background and geometry
+constexpr float kBackgroundDepth = 1e10f;
+// albedos below this are not divided out
+constexpr float kMinAlbedo = 1e-3f;
+
+using Plane = std::vector<float>;
+
+// Per-pixel data the filter reads, one plane per channel.
+struct Guides {
+  int width, height;
+  std::array<Plane, 3> normal;
+  Plane depth, inv_depth;
+};
+
+// The edge-stopping terms of one pass, as 1 / sigma^2.
+struct PassParams {
+  int step;
+  float inv_color, inv_normal, inv_depth;
+};
+
+// exp(x) for x <= 0, to about 1e-6 relative. The same arithmetic as
+// FastExp8 so both paths weigh taps alike.
+inline float FastExp(float x) {
+  x = std::max(x, -87.f);
+  const float n = std::nearbyint(x * 1.44269504f);
+  const float f = x - n * 0.693147181f;
+  float p = 1 / 120.f;
+  p = p * f + 1 / 24.f;
+  p = p * f + 1 / 6.f;
+  p = p * f + 0.5f;
+  p = p * f + 1;
+  p = p * f + 1;
+  return p * std::bit_cast<float>((static_cast<int32_t>(n) + 127) << 23);
+}
+
+// One filtered pixel, skipping taps outside the image.
+void FilterPixel(int x,
+                 int y,
+                 const PassParams& pass,
+                 const Guides& g,
+                 const std::array<Plane, 3>& in,
+                 const std::array<Plane, 3>& tone,
+                 std::array<Plane, 3>& out) {
+  const size_t p = size_t(y) * g.width + x;
+  float sum[3] = {0, 0, 0}, weight_sum = 0;
+  for (int dy = -2; dy <= 2; ++dy) {
+    const int qy = y + dy * pass.step;
+    if (qy < 0 || qy >= g.height)
+      continue;
+    for (int dx = -2; dx <= 2; ++dx) {
+      const int qx = x + dx * pass.step;
+      if (qx < 0 || qx >= g.width)
+        continue;
+      const size_t q = size_t(qy) * g.width + qx;
+      float dc = 0, dn = 0;
+      for (int c = 0; c < 3; ++c) {
+        const float tc = tone[c][q] - tone[c][p];
+        const float tn = g.normal[c][q] - g.normal[c][p];
+        dc += tc * tc;
+        dn += tn * tn;
+      }
+      const float dz = (g.depth[q] - g.depth[p]) * g.inv_depth[p];
+      const float w =
+          kKernel[dy + 2] * kKernel[dx + 2] *
+          FastExp(-(dc * pass.inv_color + dn * pass.inv_normal +
+                    dz * dz * pass.inv_depth));
+      for (int c = 0; c < 3; ++c)
+        sum[c] += w * in[c][q];
+      weight_sum += w;
+    }
+  }
+  // the center tap always has a positive weight
+  for (int c = 0; c < 3; ++c)
+    out[c][p] = sum[c] / weight_sum;
+}
+
+#if defined(ENABLE_SIMD) && defined(__AVX2__)
+__m256 FastExp8(__m256 x) {
+  x = _mm256_max_ps(x, _mm256_set1_ps(-87.f));
+  const __m256 n =
+      _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)),
+                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  const __m256 f =
+      _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693147181f)));
+  __m256 p = _mm256_set1_ps(1 / 120.f);
+  for (float coeff : {1 / 24.f, 1 / 6.f, 0.5f, 1.f, 1.f})
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(coeff));
+  const __m256i e = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(e));
+}
+
+// Pixels x .. x + 7 of row y, whose taps must all lie within the row.
+void FilterSpan8(int x,
+                 int y,
+                 const PassParams& pass,
+                 const Guides& g,
+                 const std::array<Plane, 3>& in,
+                 const std::array<Plane, 3>& tone,
+                 std::array<Plane, 3>& out) {
+  const size_t p = size_t(y) * g.width + x;
+  __m256 tone_p[3], normal_p[3];
+  for (int c = 0; c < 3; ++c) {
+    tone_p[c] = _mm256_loadu_ps(&tone[c][p]);
+    normal_p[c] = _mm256_loadu_ps(&g.normal[c][p]);
+  }
+  const __m256 depth_p = _mm256_loadu_ps(&g.depth[p]);
+  const __m256 inv_depth_p = _mm256_loadu_ps(&g.inv_depth[p]);
+  const __m256 inv_color = _mm256_set1_ps(-pass.inv_color);
+  const __m256 inv_normal = _mm256_set1_ps(-pass.inv_normal);
+  const __m256 inv_depth = _mm256_set1_ps(-pass.inv_depth);
+
+  __m256 sum[3] = {_mm256_setzero_ps(), _mm256_setzero_ps(),
+                   _mm256_setzero_ps()};
+  __m256 weight_sum = _mm256_setzero_ps();
+  for (int dy = -2; dy <= 2; ++dy) {
+    const int qy = y + dy * pass.step;
+    if (qy < 0 || qy >= g.height)
+      continue;
+    for (int dx = -2; dx <= 2; ++dx) {
+      const size_t q = size_t(qy) * g.width + x + dx * pass.step;
+      __m256 dc = _mm256_setzero_ps(), dn = _mm256_setzero_ps();
+      for (int c = 0; c < 3; ++c) {
+        const __m256 tc =
+            _mm256_sub_ps(_mm256_loadu_ps(&tone[c][q]), tone_p[c]);
+        const __m256 tn =
+            _mm256_sub_ps(_mm256_loadu_ps(&g.normal[c][q]), normal_p[c]);
+        dc = _mm256_add_ps(dc, _mm256_mul_ps(tc, tc));
+        dn = _mm256_add_ps(dn, _mm256_mul_ps(tn, tn));
+      }
+      const __m256 dz = _mm256_mul_ps(
+          _mm256_sub_ps(_mm256_loadu_ps(&g.depth[q]), depth_p), inv_depth_p);
+      const __m256 e = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(dc, inv_color),
+                        _mm256_mul_ps(dn, inv_normal)),
+          _mm256_mul_ps(_mm256_mul_ps(dz, dz), inv_depth));
+      const __m256 w =
+          _mm256_mul_ps(_mm256_set1_ps(kKernel[dy + 2] * kKernel[dx + 2]),
+                        FastExp8(e));
+      for (int c = 0; c < 3; ++c)
+        sum[c] = _mm256_add_ps(
+            sum[c], _mm256_mul_ps(w, _mm256_loadu_ps(&in[c][q])));
+      weight_sum = _mm256_add_ps(weight_sum, w);
+    }
+  }
+  for (int c = 0; c < 3; ++c)
+    _mm256_storeu_ps(&out[c][p], _mm256_div_ps(sum[c], weight_sum));
+}
+#endif
+
+void FilterRow(int y,
+               const PassParams& pass,
+               const Guides& g,
+               const std::array<Plane, 3>& in,
+               const std::array<Plane, 3>& tone,
+               std::array<Plane, 3>& out) {
+  int x = 0;
+#if defined(ENABLE_SIMD) && defined(__AVX2__)
+  // spans whose taps stay inside the row go 8 pixels at a time
+  const int span_begin = std::min(2 * pass.step, g.width);
+  const int span_end = g.width - 2 * pass.step - 8;
+  for (; x < span_begin; ++x)
+    FilterPixel(x, y, pass, g, in, tone, out);
+  for (; x <= span_end; x += 8)
+    FilterSpan8(x, y, pass, g, in, tone, out);
+#endif
+  for (; x < g.width; ++x)
+    FilterPixel(x, y, pass, g, in, tone, out);
+}
+
+}  // namespace
+
+Film Denoise(const Film& film,
+             const AovFilm& guides,
+             const DenoiseOptions& opt) {
+  const int w = film.Width(), h = film.Height();
+  if (guides.Width() != w || guides.Height() != h)
+    throw std::runtime_error(
+        std::format("denoise: guides are {}x{}, the image is {}x{}",
+                    guides.Width(), guides.Height(), w, h));
+  if (opt.iterations < 0 || opt.sigma_color <= 0 || opt.sigma_normal <= 0 ||
+      opt.sigma_depth <= 0)
+    throw std::runtime_error("denoise: invalid options");
+  const size_t n = size_t(w) * h;
+
+  // planar copies of the inputs, with the albedo divided out
+  Guides g{.width = w, .height = h};
+  std::array<Plane, 3> albedo, color, next, tone;
+  for (int c = 0; c < 3; ++c) {
+    g.normal[c].resize(n);
+    albedo[c].resize(n);
+    color[c].resize(n);
+    next[c].resize(n);
+    tone[c].resize(n);
+  }
+  g.depth.resize(n);
+  g.inv_depth.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      g.normal[c][i] = guides.NormalData()[i * 3 + c];
+      const float a = guides.AlbedoData()[i * 3 + c];
+      albedo[c][i] = a < kMinAlbedo ? 1.f : a;
+      color[c][i] = film.Data()[i * 3 + c] / albedo[c][i];
+    }
+    const float z = guides.DepthData()[i];
+    g.depth[i] = std::isfinite(z) ? z : kBackgroundDepth;
+    g.inv_depth[i] = g.depth[i] > 0 ? 1 / g.depth[i] : 0.f;
+  }
+
+  const float sigma_n = static_cast<float>(opt.sigma_normal);
+  const float sigma_z = static_cast<float>(opt.sigma_depth);
+  for (int i = 0; i < opt.iterations; ++i) {
+    const float sigma_c = static_cast<float>(opt.sigma_color) / (1 << i);
+    const PassParams pass{.step = 1 << i,
+                          .inv_color = 1 / (sigma_c * sigma_c),
+                          .inv_normal = 1 / (sigma_n * sigma_n),
+                          .inv_depth = 1 / (sigma_z * sigma_z)};
+    for (int c = 0; c < 3; ++c)
+      for (size_t k = 0; k < n; ++k)
+        tone[c][k] = color[c][k] / (1 + color[c][k]);
+    ParallelFor(
+        0, h,
+        [&](size_t begin, size_t end) {
+          for (size_t y = begin; y < end; ++y)
+            FilterRow(static_cast<int>(y), pass, g, color, tone, next);
+        },
+        8);
+    std::swap(color, next);
+  }
+
+  Film out(w, h);
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x) {
+      const size_t i = size_t(y) * w + x;
+      out.SetPixel(x, y,
+                   Color(color[0][i] * albedo[0][i], color[1][i] * albedo[1][i],
+                         color[2][i] * albedo[2][i]));
+    }
+  return out;
+}
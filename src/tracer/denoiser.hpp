@@ -0,0 +1,30 @@
+#pragma once
+
+#include "film.hpp"
+
+struct DenoiseOptions {
+  // filter passes, pass i samples its 5x5 taps 2^i pixels apart
+  int iterations = 5;
+  // Edge-stopping widths. Colors are compared after compressing them to
+  // [0, 1) by c / (1 + c), and sigma_color halves every pass. Depths are
+  // compared relative to the depth of the center pixel.
+  Float sigma_color = 0.5;
+  Float sigma_normal = 0.3;
+  Float sigma_depth = 0.1;
+};
+
+/**
+ * Edge-avoiding à-trous wavelet filter (Dammertz et al. 2010)
+ * ---------------------------------------------------------
+ * Blurs `film` with a growing B3-spline kernel, where every tap is weighted
+ * down by how much its color, shading normal and depth differ from those of
+ * the center pixel, so edges in the guides survive. The radiance is divided
+ * by the albedo AOV before filtering and multiplied back afterwards, which
+ * keeps texture detail out of the blur.
+ *
+ * Rows are filtered on NumThreads() threads, with AVX2 lanes of 8 pixels
+ * when built with ENABLE_SIMD.
+ */
+Film Denoise(const Film& film,
+             const AovFilm& guides,
+             const DenoiseOptions& opt = DenoiseOptions());
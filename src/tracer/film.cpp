@@ -0,0 +1,194 @@
+#include "film.hpp"
+
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfFrameBuffer.h>
+#include <OpenEXR/ImfHeader.h>
+#include <OpenEXR/ImfOutputFile.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <bit>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+ImageFormat ImageFormatFromPath(const std::filesystem::path& path) {
+  const std::string ext = path.extension().string();
+  if (ext == ".exr")
+    return ImageFormat::Exr;
+  if (ext == ".pfm")
+    return ImageFormat::Pfm;
+  if (ext == ".ppm")
+    return ImageFormat::Ppm;
+  if (ext == ".png")
+    return ImageFormat::Png;
+  throw std::runtime_error(std::format(
+      "{}: unsupported image format, use .exr, .pfm, .ppm or .png",
+      path.string()));
+}
+
+namespace {
+
+// header and pixels go out in one write each
+void WriteBinary(const std::filesystem::path& path,
+                 const std::string& header,
+                 const void* data,
+                 size_t size) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(header.data(), header.size());
+  out.write(static_cast<const char*>(data), size);
+  if (!out)
+    throw std::runtime_error(std::format("{}: write failed", path.string()));
+}
+
+void WritePfm(const std::filesystem::path& path, const Film& film) {
+  // PFM stores the bottom row first, the sign of the scale gives the byte
+  // order (negative: little endian)
+  const int w = film.Width(), h = film.Height();
+  std::vector<float> rows(film.Data().size());
+  for (int y = 0; y < h; ++y)
+    std::copy_n(film.Data().begin() + size_t(h - 1 - y) * w * 3, w * 3,
+                rows.begin() + size_t(y) * w * 3);
+  const char* scale = std::endian::native == std::endian::little ? "-1" : "1";
+  WriteBinary(path, std::format("PF\n{} {}\n{}\n", w, h, scale), rows.data(),
+              rows.size() * sizeof(float));
+}
+
+void WritePpm(const std::filesystem::path& path, const Film& film) {
+  const std::vector<uint8_t> pixels = Tonemap8(film);
+  WriteBinary(path,
+              std::format("P6\n{} {}\n255\n", film.Width(), film.Height()),
+              pixels.data(), pixels.size());
+}
+
+void WritePng(const std::filesystem::path& path, const Film& film) {
+  const std::vector<uint8_t> pixels = Tonemap8(film);
+  if (!stbi_write_png(path.string().c_str(), film.Width(), film.Height(), 3,
+                      pixels.data(), film.Width() * 3))
+    throw std::runtime_error(std::format("{}: write failed", path.string()));
+}
+
+}  // namespace
+
+Film::Film(int width, int height)
+    : width_(width), height_(height), rgb_(size_t(width) * height * 3, 0.f) {}
+
+void Film::SetPixel(int x, int y, const Color& c) {
+  float* p = &rgb_[(size_t(y) * width_ + x) * 3];
+  p[0] = static_cast<float>(c.r());
+  p[1] = static_cast<float>(c.g());
+  p[2] = static_cast<float>(c.b());
+}
+
+Color Film::GetPixel(int x, int y) const {
+  const float* p = &rgb_[(size_t(y) * width_ + x) * 3];
+  return Color(p[0], p[1], p[2]);
+}
+
+void Film::Write(const std::filesystem::path& path) const {
+  switch (ImageFormatFromPath(path)) {
+    case ImageFormat::Exr:
+      return WriteExr(path, *this, nullptr);
+    case ImageFormat::Pfm:
+      return WritePfm(path, *this);
+    case ImageFormat::Ppm:
+      return WritePpm(path, *this);
+    case ImageFormat::Png:
+      return WritePng(path, *this);
+  }
+}
+
+// -----------------------------------------------------------------------------
+AovFilm::AovFilm(int width, int height)
+    : width_(width),
+      height_(height),
+      albedo_(size_t(width) * height * 3, 0.f),
+      normal_(size_t(width) * height * 3, 0.f),
+      depth_(size_t(width) * height, 0.f),
+      primitive_id_(size_t(width) * height, 0),
+      material_id_(size_t(width) * height, 0),
+      sample_count_(size_t(width) * height, 0) {}
+
+void AovFilm::SetPixel(int x, int y, const AovPixel& p) {
+  const size_t i = size_t(y) * width_ + x;
+  for (int c = 0; c < 3; ++c) {
+    albedo_[i * 3 + c] = static_cast<float>(p.albedo[c]);
+    normal_[i * 3 + c] = static_cast<float>(p.normal[c]);
+  }
+  depth_[i] = static_cast<float>(p.depth);
+  primitive_id_[i] = p.primitive_id;
+  material_id_[i] = p.material_id;
+  sample_count_[i] = p.sample_count;
+}
+
+AovPixel AovFilm::GetPixel(int x, int y) const {
+  const size_t i = size_t(y) * width_ + x;
+  return AovPixel{
+      .albedo = Color(albedo_[i * 3], albedo_[i * 3 + 1], albedo_[i * 3 + 2]),
+      .normal = Vector3(normal_[i * 3], normal_[i * 3 + 1], normal_[i * 3 + 2]),
+      .depth = depth_[i],
+      .primitive_id = primitive_id_[i],
+      .material_id = material_id_[i],
+      .sample_count = sample_count_[i]};
+}
+
+void WriteExr(const std::filesystem::path& path,
+              const Film& film,
+              const AovFilm* aovs) {
+  using namespace OPENEXR_IMF_NAMESPACE;
+
+  const int w = film.Width(), h = film.Height();
+  if (aovs && (aovs->Width() != w || aovs->Height() != h))
+    throw std::runtime_error(
+        std::format("{}: AOVs do not match the image size", path.string()));
+
+  Header header(w, h);
+  FrameBuffer fb;
+  // OpenEXR only reads through the slices, the casts drop const for its API
+  auto add = [&](const char* name, PixelType type, const void* data,
+                 int components) {
+    const size_t size = type == FLOAT ? sizeof(float) : sizeof(uint32_t);
+    header.channels().insert(name, Channel(type));
+    fb.insert(name, Slice(type, static_cast<char*>(const_cast<void*>(data)),
+                          components * size, size_t(w) * components * size));
+  };
+  const float* rgb = film.Data().data();
+  add("R", FLOAT, rgb, 3);
+  add("G", FLOAT, rgb + 1, 3);
+  add("B", FLOAT, rgb + 2, 3);
+  if (aovs) {
+    add("albedo.R", FLOAT, aovs->albedo_.data(), 3);
+    add("albedo.G", FLOAT, aovs->albedo_.data() + 1, 3);
+    add("albedo.B", FLOAT, aovs->albedo_.data() + 2, 3);
+    add("normal.X", FLOAT, aovs->normal_.data(), 3);
+    add("normal.Y", FLOAT, aovs->normal_.data() + 1, 3);
+    add("normal.Z", FLOAT, aovs->normal_.data() + 2, 3);
+    add("depth.Z", FLOAT, aovs->depth_.data(), 1);
+    add("primitive.id", UINT, aovs->primitive_id_.data(), 1);
+    add("material.id", UINT, aovs->material_id_.data(), 1);
+    add("samples.count", UINT, aovs->sample_count_.data(), 1);
+  }
+
+  try {
+    OutputFile file(path.string().c_str(), header);
+    file.setFrameBuffer(fb);
+    file.writePixels(h);
+  } catch (const std::exception& e) {
+    throw std::runtime_error(std::format("{}: {}", path.string(), e.what()));
+  }
+}
+
+std::vector<uint8_t> Tonemap8(const Film& film) {
+  static const Interval<int> col_range(0, 255);
+  std::vector<uint8_t> out(film.Data().size());
+  for (int y = 0, i = 0; y < film.Height(); ++y)
+    for (int x = 0; x < film.Width(); ++x) {
+      const Color rgb = Format_Color(film.GetPixel(x, y), 255.999);
+      for (int c = 0; c < 3; ++c)
+        out[i++] = static_cast<uint8_t>(
+            col_range.Clamp(static_cast<int>(rgb[c])));
+    }
+  return out;
+}
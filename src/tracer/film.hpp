@@ -0,0 +1,88 @@
+#pragma once
+
+#include "util/util.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+enum class ImageFormat { Exr, Pfm, Ppm, Png };
+
+// The format for `path`, by its extension. Throws std::runtime_error on an
+// unsupported one.
+ImageFormat ImageFormatFromPath(const std::filesystem::path& path);
+
+/**
+ * Film
+ * ----
+ * Linear RGB radiance per pixel, stored as 32-bit floats, row-major with the
+ * top row first. Nothing is clamped or quantized until the film is written:
+ *  - .exr and .pfm keep the HDR values,
+ *  - .ppm (binary P6) and .png go through Tonemap8 first.
+ */
+class Film {
+ public:
+  Film(int width, int height);
+
+  int Width() const noexcept { return width_; }
+  int Height() const noexcept { return height_; }
+
+  void SetPixel(int x, int y, const Color& c);
+  Color GetPixel(int x, int y) const;
+  // interleaved RGB
+  std::span<const float> Data() const { return rgb_; }
+
+  // Throws std::runtime_error if the file cannot be written.
+  void Write(const std::filesystem::path& path) const;
+
+ private:
+  int width_, height_;
+  std::vector<float> rgb_;
+};
+
+// Auxiliary outputs (AOVs) of one pixel, describing what its camera rays hit
+// first.
+struct AovPixel {
+  Color albedo;     // mean over the samples
+  Vector3 normal;   // mean shading normal, not renormalized
+  Float depth;      // mean distance to the camera, infinite if nothing hit
+  uint32_t primitive_id;  // of the first sample, 0 for none
+  uint32_t material_id;   // of the first sample, 0 for none
+  uint32_t sample_count;
+};
+
+class AovFilm {
+ public:
+  AovFilm(int width, int height);
+
+  int Width() const noexcept { return width_; }
+  int Height() const noexcept { return height_; }
+
+  void SetPixel(int x, int y, const AovPixel& p);
+  AovPixel GetPixel(int x, int y) const;
+  // row-major planes, albedo and normal interleaved
+  std::span<const float> AlbedoData() const { return albedo_; }
+  std::span<const float> NormalData() const { return normal_; }
+  std::span<const float> DepthData() const { return depth_; }
+
+ private:
+  friend void WriteExr(const std::filesystem::path&,
+                       const Film&,
+                       const AovFilm*);
+
+  int width_, height_;
+  std::vector<float> albedo_, normal_, depth_;  // RGB and XYZ interleaved
+  std::vector<uint32_t> primitive_id_, material_id_, sample_count_;
+};
+
+// Writes `film` as the RGB channels of an EXR. With `aovs`, these follow as
+// extra layers: albedo.{R,G,B}, normal.{X,Y,Z}, depth.Z as floats and
+// primitive.id, material.id, samples.count as unsigned ints.
+void WriteExr(const std::filesystem::path& path,
+              const Film& film,
+              const AovFilm* aovs = nullptr);
+
+// The display pass for 8-bit outputs: gamma 2.2, clamped and quantized to
+// interleaved RGB bytes.
+std::vector<uint8_t> Tonemap8(const Film& film);
@@ -2,16 +2,25 @@
 
 #include "bsdf.hpp"
 #include "bxdfs/lambertian.hpp"
+#include "checkpoint.hpp"
+#include "denoiser.hpp"
+#include "film.hpp"
 #include "light.hpp"
 #include "material.hpp"
 #include "primitive.hpp"
 #include "scene.hpp"
 #include "texture.hpp"
+#include "util/parallel.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
-#include <fstream>
+#include <format>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include <random>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 #include "spdlog/spdlog.h"
@@ -20,194 +29,491 @@ static inline Float absCosTheta(Vector3 wi, Normal n) {
   return std::abs(wi.Dot(n));
 }
 
+namespace {
+// Relative error of dark pixels is measured against this luminance instead,
+// so that they do not sample forever.
+constexpr Float kAdaptiveMinLuminance = 1e-2;
+}  // namespace
+
 static constexpr Float PowerHeuristic(Float pdf_a, Float pdf_b) {
   Float a2 = pdf_a * pdf_a;
   Float b2 = pdf_b * pdf_b;
   return (a2 == 0.0 && b2 == 0.0) ? 0.0 : a2 / (a2 + b2);
 }
 
-Integrator::Integrator(Scene& scene, int max_depth, bool mis_enabled)
+Integrator::Integrator(Scene& scene,
+                       int max_depth,
+                       bool mis_enabled,
+                       LightSamplerType light_sampler)
     : scene_(scene),
       max_depth_(max_depth),
       mis_enabled_(mis_enabled),
       ray_cnt_(0) {
   for (const auto& obj : scene_.GetPrimitives()) {
-    if (obj->GetLight())
+    if (obj->GetLight()) {
+      light_index_.emplace(obj.get(), lights_.size());
       lights_.push_back(obj);
+    }
   }
+  light_sampler_ = CreateLightSampler(light_sampler, lights_);
 }
 
-Color Integrator::Li(Ray r, int depth) {
-  if (depth >= max_depth_)
-    return Color(0);
+Integrator::BounceSamples Integrator::BounceSamples::Draw(Sampler& sampler) {
+  BounceSamples u;
+  u.u_material = sampler.Get1D();
+  u.u_light = sampler.Get1D();
+  u.u_light_pos = sampler.Get2D();
+  u.u_lobe = sampler.Get1D();
+  u.u_bsdf = sampler.Get2D();
+  u.u_roulette = sampler.Get1D();
+  return u;
+}
 
-  HitRecord rec = scene_.Hit(r, Interval<Float>::Positive());
-  if (!rec.hits)
-    return scene_.Background(r);
+const IMaterial* Integrator::ResolveMaterial(const HitRecord& rec,
+                                             Float u) const {
+  const IMaterial* mat = rec.primitive->GetMaterial().get();
+  while (auto mix = dynamic_cast<const MixedMaterial*>(mat))
+    mat = mix->Select(u).get();
+  return mat;
+}
 
-  Color L = rec.primitive->Le(r);
+bool Integrator::UseMis(const BSDF& bsdf) const {
+  return !bsdf.MatchesFlag(BxDFBits::Specular) && mis_enabled_ &&
+         !lights_.empty();
+}
 
-  std::shared_ptr<IMaterial> mat = rec.primitive->GetMaterial();
-  while (mat) {
-    if (auto mix = std::dynamic_pointer_cast<MixedMaterial>(mat))
-      mat = mix->Select();
-    else
-      break;
+std::optional<Integrator::LightSample> Integrator::SampleLight(
+    const Ray& r,
+    const HitRecord& rec,
+    const BSDF& bsdf,
+    const BounceSamples& u) const {
+  static constexpr Float EPS = 1e-6;
+  static constexpr Float kShadowEps = 1e-6;
+
+  const auto picked = light_sampler_->Sample(rec.position, u.u_light);
+  if (!picked)
+    return std::nullopt;
+  const auto& light_prim = lights_[picked->index];
+  auto shape = light_prim->GetShape();
+
+  ShapeSample samp = shape->Sample(rec.position, u.u_light_pos);
+  if (samp.pdf <= EPS)
+    return std::nullopt;
+  Vector3 wo = samp.pos - rec.position;
+  Float dist_sq = wo.Length_squared();
+  wo = wo.Normalized();
+  const Float shading_cos = absCosTheta(wo, rec.normal);
+  const Float light_cos = absCosTheta(-wo, samp.normal);
+  const Float pdf_light = picked->pmf * samp.pdf;
+  if (shading_cos < EPS || light_cos < EPS)
+    return std::nullopt;
+
+  // stop short of the light sample so the light itself does not occlude
+  LightSample ls{Ray(rec.position, wo),
+                 std::sqrt(dist_sq) * (1 - kShadowEps), Color(0)};
+  Color Li_light = light_prim->Le(ls.shadow);
+  const Float pdf_bsdf = bsdf.pdf(r.Direction(), wo);
+  const Float w = PowerHeuristic(pdf_light, pdf_bsdf);
+  ls.L = bsdf.f(r.Direction(), wo) * Li_light * shading_cos * w / pdf_light;
+  return ls;
+}
+
+std::optional<Integrator::Scatter> Integrator::SampleScatter(
+    const Ray& r,
+    const HitRecord& rec,
+    const BSDF& bsdf,
+    bool use_mis,
+    int depth,
+    const BounceSamples& u) const {
+  auto samp = bsdf.Sample_f(r.Direction(), u.u_lobe, u.u_bsdf);
+  if (!samp)
+    return std::nullopt;
+  const Float pdf_bsdf = samp->pdf;
+  const Float cos0 = absCosTheta(samp->wo, rec.normal);
+  if (!(pdf_bsdf > 0.0 && cos0 > 0.0))
+    return std::nullopt;
+
+  Color throughput = samp->f * cos0 / pdf_bsdf;
+  if (depth > 5) {
+    Float survive = std::max({throughput.r(), throughput.g(), throughput.b()});
+    survive = std::min<Float>(survive, 0.95);
+    if (u.u_roulette > survive)
+      return std::nullopt;
+    throughput /= survive;
   }
-  if (!mat)
-    return L;
-
-  BSDF bsdf = mat->GetBSDF(rec);
-  bool use_mis = !bsdf.MatchesFlag(BxDFBits::Specular) && mis_enabled_;
-
-  // Direct lighting via light sampling
-  auto sample_light = [&]() -> Color {
-    static constexpr Float EPS = 1e-6;
-
-    // randomly pick one light
-    size_t idx = std::min<size_t>(random_uniform_01() * lights_.size(),
-                                  lights_.size() - 1);
-    auto light_prim = lights_[idx];
-    auto shape = light_prim->GetShape();
-
-    ShapeSample samp = shape->Sample();
-    if (samp.pdf <= EPS)
-      return Color(0);
-    Vector3 wo = samp.pos - rec.position;
-    Float dist_sq = wo.Length_squared();
-    wo = wo.Normalized();
-    const Float shading_cos = absCosTheta(wo, rec.normal);
-    const Float light_cos = absCosTheta(-wo, samp.normal);
-    const Float pdf_light =
-        (1.0 / lights_.size()) * (samp.pdf * dist_sq / light_cos);
-    if (shading_cos < EPS || light_cos < EPS)
-      return Color(0);
-
-    Ray shadow(rec.position, wo);
-    HitRecord sh = scene_.Hit(shadow, Interval<Float>::Positive());
-    if (!sh.hits || sh.primitive != light_prim.get())
-      return Color(0);
-
-    Color Li_light = light_prim->Le(shadow);
-    const Float pdf_bsdf = bsdf.pdf(r.Direction(), wo);
-    const Float w = PowerHeuristic(pdf_light, pdf_bsdf);
-    Color L =
-        bsdf.f(r.Direction(), wo) * Li_light * shading_cos * w / pdf_light;
-    return L;
+  return Scatter{samp->wo, throughput, use_mis ? pdf_bsdf : Float(0)};
+}
+
+Float Integrator::EmissionWeight(const Ray& r,
+                                 Float mis_pdf,
+                                 const HitRecord& rec) const {
+  if (mis_pdf <= 0)
+    return 1;
+  const auto it = light_index_.find(rec.primitive);
+  if (it == light_index_.end())
+    return 1;
+  const Point3 ref = r.Origin();
+  const Float pdf_light = light_sampler_->Pmf(ref, it->second) *
+                          rec.primitive->GetShape()->Pdf(ref, rec);
+  return PowerHeuristic(mis_pdf, pdf_light);
+}
+
+FirstHit FirstHit::At(const Ray& r, const HitRecord& rec) {
+  FirstHit hit;
+  hit.primitive = rec.primitive;
+  hit.material = rec.primitive->GetMaterial().get();
+  if (hit.material)
+    hit.albedo = hit.material->Albedo(rec);
+  hit.normal = Vector3(rec.normal);
+  hit.distance = rec.time * r.Direction().Length();
+  return hit;
+}
+
+Color Integrator::Li(Ray r, Sampler& sampler, FirstHit* first_hit) {
+  // Each vertex adds its emitted and directly sampled light, plus the light
+  // arriving from further down the path scaled by the vertex throughput. The
+  // loop records both per vertex and sums them back to front at the end,
+  //   L = L_0 + t_0 * (L_1 + t_1 * (L_2 + ...)),
+  // which is the exact order of operations of a recursive evaluation.
+  struct Vertex {
+    Color L, throughput;
   };
+  thread_local std::vector<Vertex> path;
+  path.clear();
+
+  // radiance leaving the last vertex of the path
+  Color tail(0);
+  // of the BSDF sample that continued the path, see Scatter
+  Float mis_pdf = 0;
+  for (int depth = 0; depth < max_depth_; ++depth) {
+    // drawn up front to keep the dimensions of every bounce aligned
+    const BounceSamples u = BounceSamples::Draw(sampler);
+
+    HitRecord rec = scene_.Hit(r, Interval<Float>::Positive());
+    if (depth == 0 && first_hit)
+      *first_hit = rec.hits ? FirstHit::At(r, rec) : FirstHit();
+    if (!rec.hits) {
+      tail = scene_.Background(r);
+      break;
+    }
 
-  if (lights_.empty())
-    use_mis = false;
-  if (use_mis)
-    L += sample_light();
-
-  if (auto samp = bsdf.Sample_f(r.Direction())) {
-    const Float pdf_bsdf = samp->pdf;
-    const Float cos0 = absCosTheta(samp->wo, rec.normal);
-
-    if (pdf_bsdf > 0.0 && cos0 > 0.0) {
-      Float w = 1.0;
-      if (use_mis) {
-        Float pdf_light = 0;
-        for (const auto& it : lights_)
-          pdf_light += it->GetShape()->Pdf(rec.position, samp->wo);
-        w = PowerHeuristic(pdf_bsdf, pdf_light);
-      }
+    Color L = rec.primitive->Le(r) * EmissionWeight(r, mis_pdf, rec);
 
-      Color throughput = samp->f * cos0 * w / pdf_bsdf;
-      if (depth > 5) {
-        Float survive =
-            std::max({throughput.r(), throughput.g(), throughput.b()});
-        survive = std::min<Float>(survive, 0.95);
-        if (random_uniform_01() > survive)
-          return L;
-        else
-          throughput /= survive;
-      }
+    const IMaterial* mat = ResolveMaterial(rec, u.u_material);
+    if (!mat) {
+      tail = L;
+      break;
+    }
 
-      Ray scattered(rec.position, samp->wo);
-      const Color Li_scatter = Li(scattered, depth + 1);
+    BSDF bsdf = mat->GetBSDF(rec);
+    const bool use_mis = UseMis(bsdf);
+    if (use_mis) {
+      auto ls = SampleLight(r, rec, bsdf, u);
+      L += ls && !scene_.Occluded(ls->shadow, ls->tmax) ? ls->L : Color(0);
+    }
 
-      L += throughput * Li_scatter;
+    auto scatter = SampleScatter(r, rec, bsdf, use_mis, depth, u);
+    if (!scatter) {
+      tail = L;
+      break;
     }
+
+    path.push_back({L, scatter->throughput});
+    r = Ray(rec.position, scatter->wo);
+    mis_pdf = scatter->mis_pdf;
   }
 
-  return L;
+  for (auto it = path.rbegin(); it != path.rend(); ++it)
+    tail = it->L + it->throughput * tail;
+  return tail;
 }
 
+
 void Integrator::Render(const Camera& cam,
                         std::string output_filename,
-                        const int spp) {
+                        const RenderOptions& opt) {
+  using Clock = std::chrono::steady_clock;
+  const auto start_time = Clock::now();
+  auto seconds_since = [](Clock::time_point t) {
+    return std::chrono::duration<Float>(Clock::now() - t).count();
+  };
+
   int image_width = cam.imageWidth();
   int image_height = cam.imageHeight();
   auto view = cam.initializeView();
   Point3 origin = cam.position();
 
-  // Simple RGB‐byte framebuffer
-  struct Pixel {
-    uint8_t r, g, b;
+  const bool time_limited = opt.time_limit > 0;
+  const bool checkpointing = !opt.checkpoint.empty();
+  const bool in_passes =
+      time_limited || opt.snapshot_interval > 0 || checkpointing;
+  const int pass_spp = in_passes ? std::max(opt.pass_spp, 1) : opt.spp;
+  const bool adaptive = opt.noise_threshold > 0 && !opt.wavefront;
+  if (opt.noise_threshold > 0 && opt.wavefront)
+    spdlog::warn("adaptive sampling is not supported in wavefront mode");
+  if (!time_limited && opt.spp <= 0)
+    throw std::runtime_error(
+        std::format("samples per pixel must be positive, got {}", opt.spp));
+  const int min_spp = time_limited ? std::max(opt.min_spp, 1)
+                                   : std::clamp(opt.min_spp, 1, opt.spp);
+
+  // the denoiser is guided by the AOVs, they are only written with opt.aovs
+  const bool aovs = opt.aovs || opt.denoise;
+  if (opt.aovs && ImageFormatFromPath(output_filename) != ImageFormat::Exr)
+    throw std::runtime_error(
+        std::format("{}: AOVs need an .exr output", output_filename));
+  std::optional<SceneIds> ids;
+  if (aovs || checkpointing || !opt.resume.empty())
+    ids.emplace(scene_.GetPrimitives());
+
+  Checkpoint state;
+  if (!opt.resume.empty()) {
+    state = ReadCheckpoint(opt.resume, *ids);
+    if (state.width != image_width || state.height != image_height)
+      throw std::runtime_error(std::format(
+          "{}: the checkpoint is of a {}x{} image, not {}x{}", opt.resume,
+          state.width, state.height, image_width, image_height));
+    if (state.sampler != opt.sampler)
+      throw std::runtime_error(std::format(
+          "{}: the checkpoint was rendered with another sampler", opt.resume));
+    // AOVs the checkpoint lacks are gathered from the new samples alone
+    if (aovs && !state.aovs)
+      for (PixelState& px : state.pixels)
+        px.aov = AovAccumulator();
+    // pixels only stay converged under the threshold they converged at
+    if (state.noise_threshold != (adaptive ? opt.noise_threshold : 0))
+      for (PixelState& px : state.pixels)
+        px.converged = false;
+    spdlog::info("resuming from {} at {} spp", opt.resume, state.spp);
+  } else {
+    state.width = image_width;
+    state.height = image_height;
+    state.sampler = opt.sampler;
+    // the number of samples the sampler stratifies together
+    state.sampler_spp = time_limited ? pass_spp : opt.spp;
+    state.pixels.resize(image_width * image_height);
+  }
+  state.aovs = aovs;
+  state.noise_threshold = adaptive ? opt.noise_threshold : 0;
+  std::vector<PixelState>& pixels = state.pixels;
+
+  auto resolve_aovs = [&](const AovAccumulator& acc) {
+    const Float inv_samples = Float(1) / acc.samples;
+    return AovPixel{
+        .albedo = acc.albedo * inv_samples,
+        .normal = acc.normal * inv_samples,
+        .depth = acc.hits ? acc.distance / acc.hits
+                          : std::numeric_limits<Float>::infinity(),
+        .primitive_id = ids->Id(acc.primitive),
+        .material_id = ids->Id(acc.material),
+        .sample_count = static_cast<uint32_t>(acc.samples)};
   };
-  std::vector<Pixel> framebuffer(image_width * image_height);
-
-  unsigned num_threads = std::thread::hardware_concurrency();
-  if (num_threads == 0)
-    num_threads = 4;
 
-  // Render a range of rows [y_start, y_end)
-  std::atomic<int> finished_cnt = 0;
-  auto render_rows = [&](int y_start, int y_end) {
-    for (int y = y_start; y < y_end; ++y) {
+  // Resolves the pixels gathered so far into an image and writes it.
+  auto write_output = [&]() {
+    Film film(image_width, image_height);
+    std::optional<AovFilm> aov_film;
+    if (aovs)
+      aov_film.emplace(image_width, image_height);
+    for (int y = 0; y < image_height; ++y) {
       for (int x = 0; x < image_width; ++x) {
+        const PixelState& px = pixels[y * image_width + x];
+        if (px.n == 0)
+          continue;
+        Color raw = px.sum;
+        raw /= px.n;
+        film.SetPixel(x, y, raw);
+        if (aovs && px.aov.samples > 0)
+          aov_film->SetPixel(x, y, resolve_aovs(px.aov));
+      }
+    }
+
+    if (opt.denoise) {
+      const auto begin = Clock::now();
+      film = Denoise(film, *aov_film);
+      spdlog::info("denoised in {:.0f} ms", seconds_since(begin) * 1000);
+    }
+    if (opt.aovs)
+      WriteExr(output_filename, film, &*aov_film);
+    else
+      film.Write(output_filename);
+  };
+
+  const std::vector<Tile> tiles = GenerateTiles(
+      image_width, image_height, opt.tile_size, opt.tile_order);
+
+  const std::unique_ptr<Sampler> sampler_proto =
+      CreateSampler(state.sampler, state.sampler_spp, state.seed);
+
+  // Every pass renders the tiles again, and each pixel takes samples until
+  // it has `end` of them or has converged. Wavefront mode traces all samples
+  // of a tile in waves of kWaveSize paths.
+  static constexpr size_t kWaveSize = 4096;
+  auto render_tile_wavefront = [&](const Tile& tile, Sampler& sampler,
+                                   int end) {
+    thread_local std::vector<PixelSample> samples;
+    thread_local std::vector<Color> radiance;
+    thread_local std::vector<FirstHit> first_hits;
+    samples.clear();
+    for (int y = tile.y0; y < tile.y1; ++y)
+      for (int x = tile.x0; x < tile.x1; ++x)
+        for (int i = pixels[y * image_width + x].n; i < end; ++i)
+          samples.push_back({x, y, i});
+    radiance.resize(samples.size());
+    first_hits.resize(aovs ? samples.size() : 0);
+    for (size_t begin = 0; begin < samples.size(); begin += kWaveSize) {
+      const size_t count = std::min(kWaveSize, samples.size() - begin);
+      TraceWavefront(
+          std::span(samples).subspan(begin, count), view, origin, sampler,
+          std::span(radiance).subspan(begin, count),
+          aovs ? std::span(first_hits).subspan(begin, count)
+               : std::span<FirstHit>());
+    }
+
+    for (int y = tile.y0, k = 0; y < tile.y1; ++y) {
+      for (int x = tile.x0; x < tile.x1; ++x) {
+        PixelState& px = pixels[y * image_width + x];
+        for (; px.n < end; ++px.n, ++k) {
+          px.sum += radiance[k];
+          if (aovs)
+            px.aov.Add(first_hits[k]);
+        }
+      }
+    }
+    ray_cnt_ += samples.size();
+  };
+
+  auto render_tile = [&](const Tile& tile, Sampler& sampler, int end) {
+    if (opt.wavefront)
+      return render_tile_wavefront(tile, sampler, end);
+
+    size_t tile_samples = 0;
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      for (int x = tile.x0; x < tile.x1; ++x) {
+        PixelState& px = pixels[y * image_width + x];
+        if (adaptive && px.converged)
+          continue;
         // base point on the film
         Point3 pixel_center =
             view.pixel00_loc + view.pixel_delta_u * x + view.pixel_delta_v * y;
 
-        Color raw(0, 0, 0);
-        for (int i = 0; i < spp; ++i) {
-          Point3 jittered = pixel_center +
-                            random_uniform_01() * view.pixel_delta_u +
-                            random_uniform_01() * view.pixel_delta_v;
+        const int begin = px.n;
+        FirstHit first_hit;
+        while (px.n < end) {
+          sampler.StartPixelSample(x, y, px.n);
+          const Point2 u_pixel = sampler.Get2D();
+          Point3 jittered = pixel_center + u_pixel.x() * view.pixel_delta_u +
+                            u_pixel.y() * view.pixel_delta_v;
           Ray r(origin, jittered - origin);
-          raw += Li(r, 0);
-          ++ray_cnt_;
+          const Color L = Li(r, sampler, aovs ? &first_hit : nullptr);
+          px.sum += L;
+          const int n = ++px.n;
+          if (aovs)
+            px.aov.Add(first_hit);
+
+          if (!adaptive)
+            continue;
+          const Float lum = L.Luminance();
+          const Float delta = lum - px.mean;
+          px.mean += delta / n;
+          px.m2 += delta * (lum - px.mean);
+          if (n >= min_spp) {
+            const Float std_error = std::sqrt(px.m2 / (n - 1) / n);
+            if (std_error < opt.noise_threshold *
+                                std::max(px.mean, kAdaptiveMinLuminance)) {
+              px.converged = true;
+              break;
+            }
+          }
         }
-        raw /= spp;
-
-        Color rgb = Format_Color(raw, 255.999);
-        static const Interval<int> col_range(0, 255);
-        Pixel p;
-        p.r = static_cast<uint8_t>(col_range.Clamp(static_cast<int>(rgb.r())));
-        p.g = static_cast<uint8_t>(col_range.Clamp(static_cast<int>(rgb.g())));
-        p.b = static_cast<uint8_t>(col_range.Clamp(static_cast<int>(rgb.b())));
-        framebuffer[y * image_width + x] = p;
+        tile_samples += px.n - begin;
       }
-
-      spdlog::info("finished {}/{}", ++finished_cnt, image_height);
     }
+    ray_cnt_ += tile_samples;
   };
 
-  // Spawn threads
-  std::vector<std::thread> threads;
-  int rows_per_thread = image_height / num_threads;
-  int y0 = 0;
-  for (unsigned i = 0; i < num_threads; ++i) {
-    int y1 = (i + 1 == num_threads) ? image_height : y0 + rows_per_thread;
-    threads.emplace_back(render_rows, y0, y1);
-    y0 = y1;
-  }
+  // Workers keep claiming tiles until none are left, so an expensive region
+  // of the image is shared by every thread instead of stalling one of them.
+  auto run_pass = [&](int end) {
+    TileScheduler scheduler(tiles);
+    std::atomic<size_t> finished_cnt = 0;
+    auto worker = [&]() {
+      std::unique_ptr<Sampler> sampler = sampler_proto->Clone();
+      while (std::optional<Tile> tile = scheduler.Next()) {
+        render_tile(*tile, *sampler, end);
+        // log about every percent of the tiles, unless the passes are short
+        const size_t done = ++finished_cnt;
+        if (!in_passes && done * 100 / scheduler.Size() !=
+                              (done - 1) * 100 / scheduler.Size())
+          spdlog::info("finished {}/{} tiles", done, scheduler.Size());
+      }
+    };
+
+    const unsigned num_threads =
+        std::min<size_t>(NumThreads(), std::max<size_t>(scheduler.Size(), 1));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < num_threads; ++i)
+      threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads)
+      t.join();
+  };
 
-  // Join them
-  for (auto& t : threads)
-    t.join();
-
-  // Dump to PPM
-  std::ofstream out(output_filename);
-  out << "P3\n" << image_width << ' ' << image_height << "\n255\n";
-  for (int y = 0; y < image_height; ++y) {
-    for (int x = 0; x < image_width; ++x) {
-      const Pixel& p = framebuffer[y * image_width + x];
-      out << static_cast<int>(p.r) << ' ' << static_cast<int>(p.g) << ' '
-          << static_cast<int>(p.b) << '\n';
+  // A time-limited render only starts a pass if one as long as the last
+  // still fits the budget.
+  int& spp = state.spp;
+  auto last_snapshot = start_time, last_checkpoint = start_time;
+  while (time_limited || spp < opt.spp) {
+    const auto pass_start = Clock::now();
+    spp = time_limited ? spp + pass_spp : std::min(spp + pass_spp, opt.spp);
+    run_pass(spp);
+
+    const bool done =
+        time_limited
+            ? seconds_since(start_time) + seconds_since(pass_start) >
+                  opt.time_limit
+            : spp >= opt.spp;
+    if (done ||
+        (adaptive && std::ranges::all_of(pixels, &PixelState::converged)))
+      break;
+    if (opt.snapshot_interval > 0 &&
+        seconds_since(last_snapshot) >= opt.snapshot_interval) {
+      write_output();
+      last_snapshot = Clock::now();
+      spdlog::info("wrote a snapshot at {} spp", spp);
+    }
+    if (checkpointing &&
+        seconds_since(last_checkpoint) >= opt.checkpoint_interval) {
+      WriteCheckpoint(opt.checkpoint, state, *ids);
+      last_checkpoint = Clock::now();
+      spdlog::info("wrote a checkpoint at {} spp", spp);
     }
   }
+  if (time_limited)
+    spdlog::info("time limit: {} spp in {:.1f} s", spp,
+                 seconds_since(start_time));
+
+  // the final state too, so that more samples can be added later
+  if (checkpointing)
+    WriteCheckpoint(opt.checkpoint, state, *ids);
+  write_output();
+
+  if (adaptive) {
+    const size_t total = std::transform_reduce(
+        pixels.begin(), pixels.end(), size_t{0}, std::plus<>(),
+        [](const PixelState& px) { return static_cast<size_t>(px.n); });
+    spdlog::info("adaptive sampling: {:.1f} spp on average",
+                 static_cast<Float>(total) / pixels.size());
+  }
+  if (!opt.spp_image.empty()) {
+    // the fraction of the most samples a pixel could take
+    Film counts(image_width, image_height);
+    for (int y = 0; y < image_height; ++y)
+      for (int x = 0; x < image_width; ++x) {
+        const Float v =
+            static_cast<Float>(pixels[y * image_width + x].n) / spp;
+        counts.SetPixel(x, y, Color(v, v, v));
+      }
+    counts.Write(opt.spp_image);
+  }
 }
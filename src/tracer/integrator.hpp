@@ -1,29 +1,175 @@
 #pragma once
 
 #include "camera.hpp"
+#include "light_sampler.hpp"
+#include "sampler.hpp"
+#include "tile.hpp"
 #include "util/util.hpp"
+#include "wavefront.hpp"
 
 #include <atomic>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-class Scene;
+class BSDF;
+class IMaterial;
 class Primitive;
+class Scene;
+struct HitRecord;
+
+struct RenderOptions {
+  int spp = 32;
+  // The image is split into tile_size x tile_size tiles that worker threads
+  // claim one at a time, NumThreads() workers in total.
+  int tile_size = 16;
+  TileOrder tile_order = TileOrder::Scanline;
+  SamplerType sampler = SamplerType::Sobol;
+
+  // Adaptive sampling, off while noise_threshold is 0. Each pixel takes
+  // between min_spp and spp samples and stops as soon as the standard error
+  // of its mean luminance, relative to that mean, is below noise_threshold.
+  Float noise_threshold = 0;
+  int min_spp = 16;
+  // if not empty, the number of samples each pixel took is written there as
+  // a grayscale image, white for spp
+  std::string spp_image;
+
+  // Trace the samples of a tile in waves, see wavefront.hpp. Same estimator
+  // and sample dimensions as the path-at-a-time loop of Li. Does not support
+  // adaptive sampling.
+  bool wavefront = false;
+
+  // Also write the first-hit AOVs (albedo, normal, depth, primitive and
+  // material ids, sample count) as extra layers of the output, which must be
+  // an .exr then.
+  bool aovs = false;
+  // Filter the image with Denoise before it is written, guided by the AOVs.
+  bool denoise = false;
+
+  // Progressive rendering. With a positive time_limit (seconds), passes of
+  // pass_spp samples per pixel are added to the whole image for as long as
+  // the next pass is expected to fit, and spp is ignored. With a positive
+  // snapshot_interval (seconds), the image so far is written to the output
+  // between passes, at most that often; fixed-spp renders then run in passes
+  // too. Passes do not change the result, only when it is written.
+  Float time_limit = 0;
+  Float snapshot_interval = 0;
+  int pass_spp = 4;
+
+  // If not empty, the render state is saved there between passes, at most
+  // every checkpoint_interval seconds, and once more at the end. See
+  // checkpoint.hpp.
+  std::string checkpoint;
+  Float checkpoint_interval = 60;
+  // If not empty, the render continues from this checkpoint, which must be
+  // of the same image and sampler, and adds samples up to spp (or for
+  // time_limit seconds).
+  std::string resume;
+};
+
+// What the camera ray of a path hit first, for the AOVs. `primitive` is null
+// if the ray escaped.
+struct FirstHit {
+  const Primitive* primitive = nullptr;
+  const IMaterial* material = nullptr;  // before resolving mixed materials
+  Color albedo = Color(0);
+  Vector3 normal = Vector3(0, 0, 0);
+  Float distance = 0;
+
+  static FirstHit At(const Ray& r, const HitRecord& rec);
+};
 
 class Integrator {
  public:
-  Integrator(Scene& scene, int max_depth, bool mis_enabled = true);
+  // Shadow rays go to lights chosen by a `light_sampler` built over the
+  // emissive primitives of `scene`.
+  Integrator(Scene& scene,
+             int max_depth,
+             bool mis_enabled = true,
+             LightSamplerType light_sampler = LightSamplerType::Bvh);
 
-  Color Li(Ray ray, int depth = 0);
+  // Radiance along `ray`. Every bounce draws the same dimensions from
+  // `sampler` in the same order, whether or not they end up being used.
+  // `first_hit`, if given, receives the first vertex of the path.
+  Color Li(Ray ray, Sampler& sampler, FirstHit* first_hit = nullptr);
 
-  void Render(const Camera& cam, std::string output_filename, const int spp);
+  void Render(const Camera& cam,
+              std::string output_filename,
+              const RenderOptions& opt = RenderOptions());
 
   inline size_t GetRaycount() const noexcept { return ray_cnt_; }
 
  private:
+  // The random numbers one bounce consumes, always drawn in this order.
+  struct BounceSamples {
+    Float u_material, u_light;
+    Point2 u_light_pos;
+    Float u_lobe;
+    Point2 u_bsdf;
+    Float u_roulette;
+
+    static BounceSamples Draw(Sampler& sampler);
+  };
+  static constexpr int kBounceDimensions = 8;
+  // Light arriving directly from a light sample, valid if `shadow` is not
+  // occluded before `tmax`.
+  struct LightSample {
+    Ray shadow;
+    Float tmax;
+    Color L;
+  };
+  // The continuation of a path: new direction and the factor it scales the
+  // light arriving from there by. Emission the new ray finds is weighted
+  // against light sampling with `mis_pdf`, the BSDF pdf of `wo`, unless that
+  // is 0.
+  struct Scatter {
+    Vector3 wo;
+    Color throughput;
+    Float mis_pdf;
+  };
+
+  // Wavefront mode: traces `samples` together, a bounce at a time, and
+  // writes the radiance of each to `out`, and its first vertex to
+  // `first_hits` unless that is empty.
+  void TraceWavefront(std::span<const PixelSample> samples,
+                      const Camera::View_Info& view,
+                      const Point3& origin,
+                      Sampler& sampler,
+                      std::span<Color> out,
+                      std::span<FirstHit> first_hits) const;
+
+  // the material at `rec`, with mixed materials resolved, or null
+  const IMaterial* ResolveMaterial(const HitRecord& rec, Float u) const;
+  bool UseMis(const BSDF& bsdf) const;
+  // next event estimation: light from one light picked by light_sampler_
+  // `rec` directly, MIS-weighted against sampling `bsdf`
+  std::optional<LightSample> SampleLight(const Ray& r,
+                                         const HitRecord& rec,
+                                         const BSDF& bsdf,
+                                         const BounceSamples& u) const;
+  // samples the BSDF and applies Russian roulette, nullopt ends the path
+  std::optional<Scatter> SampleScatter(const Ray& r,
+                                       const HitRecord& rec,
+                                       const BSDF& bsdf,
+                                       bool use_mis,
+                                       int depth,
+                                       const BounceSamples& u) const;
+  // MIS weight of the emission at `rec`, found by the ray `r` a BSDF sample
+  // with pdf `mis_pdf` continued its path with. Looks up the light that was
+  // hit instead of asking every light for its pdf.
+  Float EmissionWeight(const Ray& r,
+                       Float mis_pdf,
+                       const HitRecord& rec) const;
+
   Scene& scene_;
   std::vector<std::shared_ptr<Primitive>> lights_;
+  std::unique_ptr<LightSampler> light_sampler_;
+  // index of each light primitive in lights_
+  std::unordered_map<const Primitive*, size_t> light_index_;
 
   int max_depth_;
   bool mis_enabled_;
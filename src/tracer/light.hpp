@@ -8,6 +8,8 @@ class ILight {
   virtual ~ILight() = default;
 
   virtual Color Le(const Ray& r) const = 0;
+  // the radiance emitted in every direction, what light selection weighs
+  virtual Color Radiance() const = 0;
 };
 
 class Light : public ILight {
@@ -16,4 +18,5 @@ class Light : public ILight {
  public:
   explicit Light(Color c) : col_(std::move(c)) {}
   virtual Color Le(const Ray& r) const override { return col_; }
+  virtual Color Radiance() const override { return col_; }
 };
@@ -0,0 +1,335 @@
+#include "light_sampler.hpp"
+
+#include "light.hpp"
+#include "primitive.hpp"
+
+#include "util/constant.hpp"
+#include "util/direction_cone.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+std::optional<SampledLight> UniformLightSampler::Sample(const Point3&,
+                                                        Float u) const {
+  if (count_ == 0)
+    return std::nullopt;
+  return SampledLight{std::min<size_t>(u * count_, count_ - 1),
+                      Float(1) / count_};
+}
+
+Float UniformLightSampler::Pmf(const Point3&, size_t) const {
+  return count_ ? Float(1) / count_ : 0;
+}
+
+Float LightPower(const Primitive& light) {
+  const auto& emitter = light.GetLight();
+  if (!emitter)
+    return 0;
+  return std::max<Float>(emitter->Radiance().Luminance(), 0) *
+         light.GetShape()->Area();
+}
+
+PowerLightSampler::PowerLightSampler(
+    std::span<const std::shared_ptr<Primitive>> lights) {
+  std::vector<Float> power;
+  power.reserve(lights.size());
+  for (const auto& light : lights)
+    power.push_back(LightPower(*light));
+  table_ = AliasTable(power);
+}
+
+std::optional<SampledLight> PowerLightSampler::Sample(const Point3&,
+                                                      Float u) const {
+  if (table_.Size() == 0)
+    return std::nullopt;
+  const size_t index = table_.Sample(u);
+  return SampledLight{index, table_.Pmf(index)};
+}
+
+Float PowerLightSampler::Pmf(const Point3&, size_t index) const {
+  return table_.Pmf(index);
+}
+
+namespace {
+// cos(max(0, a - b)) and sin(max(0, a - b)) of angles given by their sines
+// and cosines
+Float CosSubClamped(Float sin_a, Float cos_a, Float sin_b, Float cos_b) {
+  return cos_a > cos_b ? 1 : cos_a * cos_b + sin_a * sin_b;
+}
+Float SinSubClamped(Float sin_a, Float cos_a, Float sin_b, Float cos_b) {
+  return cos_a > cos_b ? 0 : sin_a * cos_b - cos_a * sin_b;
+}
+Float SafeSqrt(Float x) { return std::sqrt(std::max<Float>(x, 0)); }
+Float SafeAcos(Float x) { return std::acos(std::clamp<Float>(x, -1, 1)); }
+
+// Split cost of a node (the surface area orientation heuristic): power
+// times the solid angle its normals and emission cover times the surface of
+// its box, which is stretched by `stretch` to favour splitting along the
+// longest axis.
+Float SplitCost(const LightBounds& b, Float stretch) {
+  const Float theta_o = SafeAcos(b.cos_theta_o);
+  const Float theta_e = SafeAcos(b.cos_theta_e);
+  const Float theta_w = std::min(theta_o + theta_e, pi);
+  const Float sin_theta_o = SafeSqrt(1 - Sqr(b.cos_theta_o));
+  const Float m_omega =
+      2 * pi * (1 - b.cos_theta_o) +
+      pi / 2 *
+          (2 * theta_w * sin_theta_o - std::cos(theta_o - 2 * theta_w) -
+           2 * theta_o * sin_theta_o + b.cos_theta_o);
+  return b.phi * m_omega * stretch * b.bounds.SurfaceArea();
+}
+
+constexpr int kSplitBuckets = 12;
+// below this depth nodes are split at their middle light, so a leaf is at
+// most 32 + ceil(log2(lights)) deep and its trail, with the leading 1 bit,
+// fits in 64 bits as long as there are at most kMaxLights lights
+constexpr int kMaxSahDepth = 32;
+constexpr size_t kMaxLights = size_t{1} << 31;
+}  // namespace
+
+LightBounds LightBounds::Of(const Primitive& light) {
+  const DirectionCone normals = light.GetShape()->NormalBounds();
+  LightBounds b;
+  b.bounds = light.GetBbox();
+  b.w = normals.w;
+  b.phi = LightPower(light);
+  b.cos_theta_o = normals.cos_theta;
+  // diffuse emission reaches the whole hemisphere about the normal
+  b.cos_theta_e = 0;
+  return b;
+}
+
+Float LightBounds::Importance(const Point3& p) const {
+  if (phi <= 0)
+    return 0;
+  const Point3 center = bounds.Centroid();
+  const Vector3 d = p - center;
+  // within the box the distance is taken as half its diagonal
+  const Float half_diagonal_sq =
+      (Sqr(bounds.Axis(0).Size()) + Sqr(bounds.Axis(1).Size()) +
+       Sqr(bounds.Axis(2).Size())) /
+      4;
+  const Float dist_sq = std::max(d.Length_squared(), half_diagonal_sq);
+
+  // angle between the cone axis and the direction to p, both sides emit
+  const Float len = d.Length();
+  const Float cos_theta_w =
+      len > 0 ? std::abs(Vector3::Dot(w, d)) / len : Float(1);
+  const Float sin_theta_w = SafeSqrt(1 - Sqr(cos_theta_w));
+  // less the spread of the normals and the angle the box subtends at p
+  const Float cos_theta_b = BoundSubtendedDirections(bounds, p).cos_theta;
+  const Float sin_theta_b = SafeSqrt(1 - Sqr(cos_theta_b));
+  const Float sin_theta_o = SafeSqrt(1 - Sqr(cos_theta_o));
+  const Float cos_theta_x =
+      CosSubClamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+  const Float sin_theta_x =
+      SinSubClamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+  const Float cos_theta_p =
+      CosSubClamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b);
+  if (cos_theta_p <= cos_theta_e)
+    return 0;
+  return phi * cos_theta_p / dist_sq;
+}
+
+LightBounds Union(const LightBounds& a, const LightBounds& b) {
+  if (a.phi <= 0)
+    return b;
+  if (b.phi <= 0)
+    return a;
+  const DirectionCone cone = Union(DirectionCone{a.w, a.cos_theta_o},
+                                   DirectionCone{b.w, b.cos_theta_o});
+  LightBounds u;
+  u.bounds = AABB(a.bounds, b.bounds);
+  u.w = cone.w;
+  u.phi = a.phi + b.phi;
+  u.cos_theta_o = cone.cos_theta;
+  u.cos_theta_e = std::min(a.cos_theta_e, b.cos_theta_e);
+  return u;
+}
+
+BvhLightSampler::BvhLightSampler(
+    std::span<const std::shared_ptr<Primitive>> lights) {
+  if (lights.size() > kMaxLights)
+    throw std::runtime_error(
+        std::format("bvh light sampler supports at most {} lights, got {}",
+                    kMaxLights, lights.size()));
+  trails_.assign(lights.size(), 0);
+  std::vector<BuildItem> items;
+  for (size_t i = 0; i < lights.size(); ++i) {
+    const LightBounds b = LightBounds::Of(*lights[i]);
+    if (b.phi > 0)
+      items.push_back({static_cast<uint32_t>(i), b});
+  }
+  if (items.empty())
+    return;
+  nodes_.reserve(2 * items.size() - 1);
+  Build(items, 1, 0);
+}
+
+uint32_t BvhLightSampler::Build(std::span<BuildItem> items,
+                                uint64_t trail,
+                                int depth) {
+  const uint32_t index = static_cast<uint32_t>(nodes_.size());
+  if (items.size() == 1) {
+    nodes_.push_back({items[0].bounds, items[0].light, true});
+    trails_[items[0].light] = trail;
+    return index;
+  }
+
+  LightBounds bounds;
+  AABB centroids;
+  for (const BuildItem& it : items) {
+    bounds = Union(bounds, it.bounds);
+    const Point3 c = it.bounds.bounds.Centroid();
+    centroids = AABB(centroids, AABB(c, c));
+  }
+
+  // the cheapest of the bucket boundaries along each axis
+  Float best_cost = std::numeric_limits<Float>::infinity();
+  int best_axis = -1, best_bucket = 0;
+  auto bucket_of = [&](const BuildItem& it, int axis) {
+    const Interval<Float>& extent = centroids.Axis(axis);
+    const Float t = (it.bounds.bounds.Centroid()[axis] - extent.begin) /
+                    extent.Size();
+    return std::clamp(static_cast<int>(t * kSplitBuckets), 0,
+                      kSplitBuckets - 1);
+  };
+  Float max_extent = 0;
+  for (int axis = 0; axis < 3; ++axis)
+    max_extent = std::max(max_extent, bounds.bounds.Axis(axis).Size());
+  for (int axis = 0; depth < kMaxSahDepth && axis < 3; ++axis) {
+    if (!(centroids.Axis(axis).Size() > 0))
+      continue;
+    std::array<LightBounds, kSplitBuckets> buckets;
+    for (const BuildItem& it : items) {
+      LightBounds& b = buckets[bucket_of(it, axis)];
+      b = Union(b, it.bounds);
+    }
+    const Float stretch = max_extent / bounds.bounds.Axis(axis).Size();
+    for (int split = 1; split < kSplitBuckets; ++split) {
+      LightBounds below, above;
+      for (int k = 0; k < split; ++k)
+        below = Union(below, buckets[k]);
+      for (int k = split; k < kSplitBuckets; ++k)
+        above = Union(above, buckets[k]);
+      const Float cost = SplitCost(below, stretch) + SplitCost(above, stretch);
+      if (below.phi > 0 && above.phi > 0 && cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bucket = split;
+      }
+    }
+  }
+
+  size_t mid;
+  if (best_axis >= 0) {
+    auto it = std::partition(items.begin(), items.end(), [&](const auto& x) {
+      return bucket_of(x, best_axis) < best_bucket;
+    });
+    mid = it - items.begin();
+  } else {
+    // coincident centroids or a deep tree: halve along the widest axis
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+      if (centroids.Axis(a).Size() > centroids.Axis(axis).Size())
+        axis = a;
+    mid = items.size() / 2;
+    std::nth_element(items.begin(), items.begin() + mid, items.end(),
+                     [axis](const BuildItem& a, const BuildItem& b) {
+                       return a.bounds.bounds.Centroid()[axis] <
+                              b.bounds.bounds.Centroid()[axis];
+                     });
+  }
+
+  nodes_.push_back({bounds, 0, false});
+  Build(items.first(mid), trail << 1, depth + 1);
+  nodes_[index].index =
+      Build(items.subspan(mid), (trail << 1) | 1, depth + 1);
+  return index;
+}
+
+std::optional<Float> BvhLightSampler::FirstChildProbability(
+    const Point3& ref,
+    uint32_t node) const {
+  const Float i0 = nodes_[node + 1].bounds.Importance(ref);
+  const Float i1 = nodes_[nodes_[node].index].bounds.Importance(ref);
+  if (!(i0 + i1 > 0))
+    return std::nullopt;
+  return i0 / (i0 + i1);
+}
+
+std::optional<SampledLight> BvhLightSampler::Sample(const Point3& ref,
+                                                    Float u) const {
+  if (nodes_.empty() || !(nodes_[0].bounds.Importance(ref) > 0))
+    return std::nullopt;
+  uint32_t node = 0;
+  Float pmf = 1;
+  while (!nodes_[node].leaf) {
+    const auto p0 = FirstChildProbability(ref, node);
+    if (!p0)
+      return std::nullopt;
+    // reuse u for the next level, rescaled to [0, 1)
+    if (u < *p0) {
+      node = node + 1;
+      pmf *= *p0;
+      u = std::min(u / *p0, one_minus_epsilon);
+    } else {
+      node = nodes_[node].index;
+      pmf *= 1 - *p0;
+      u = std::min((u - *p0) / (1 - *p0), one_minus_epsilon);
+    }
+  }
+  return SampledLight{nodes_[node].index, pmf};
+}
+
+Float BvhLightSampler::Pmf(const Point3& ref, size_t index) const {
+  const uint64_t trail = trails_[index];
+  if (trail == 0 || !(nodes_[0].bounds.Importance(ref) > 0))
+    return 0;
+  uint32_t node = 0;
+  Float pmf = 1;
+  // the turns follow the leading 1, first turn highest
+  for (int bit = std::bit_width(trail) - 2; bit >= 0; --bit) {
+    const auto p0 = FirstChildProbability(ref, node);
+    if (!p0)
+      return 0;
+    if ((trail >> bit) & 1) {
+      node = nodes_[node].index;
+      pmf *= 1 - *p0;
+    } else {
+      node = node + 1;
+      pmf *= *p0;
+    }
+  }
+  return pmf;
+}
+
+LightSamplerType ParseLightSamplerType(std::string_view name) {
+  if (name == "uniform")
+    return LightSamplerType::Uniform;
+  if (name == "power")
+    return LightSamplerType::Power;
+  if (name == "bvh")
+    return LightSamplerType::Bvh;
+  throw std::runtime_error(std::format("unknown light sampler: {}", name));
+}
+
+std::unique_ptr<LightSampler> CreateLightSampler(
+    LightSamplerType type,
+    std::span<const std::shared_ptr<Primitive>> lights) {
+  switch (type) {
+    case LightSamplerType::Uniform:
+      return std::make_unique<UniformLightSampler>(lights.size());
+    case LightSamplerType::Power:
+      return std::make_unique<PowerLightSampler>(lights);
+    case LightSamplerType::Bvh:
+      return std::make_unique<BvhLightSampler>(lights);
+  }
+  throw std::runtime_error("unknown light sampler type");
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "util/aabb.hpp"
+#include "util/sampling.hpp"
+#include "util/util.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+class Primitive;
+
+struct SampledLight {
+  size_t index;  // into the lights the sampler was built over
+  Float pmf;
+};
+
+/**
+ * LightSampler
+ * ------------
+ * Picks the light a shadow ray goes to. Built over the emissive primitives
+ * of a scene; `ref` is the shading point, which samplers may use to favour
+ * the lights that matter there.
+ */
+class LightSampler {
+ public:
+  virtual ~LightSampler() = default;
+
+  // u in [0, 1), nullopt if there are no lights
+  virtual std::optional<SampledLight> Sample(const Point3& ref,
+                                             Float u) const = 0;
+  // probability of Sample(ref, .) choosing light `index`
+  virtual Float Pmf(const Point3& ref, size_t index) const = 0;
+};
+
+class UniformLightSampler : public LightSampler {
+ public:
+  explicit UniformLightSampler(size_t count) : count_(count) {}
+
+  std::optional<SampledLight> Sample(const Point3& ref,
+                                     Float u) const override;
+  Float Pmf(const Point3& ref, size_t index) const override;
+
+ private:
+  size_t count_;
+};
+
+// In proportion to the emitted power, radiance luminance times area, through
+// an alias table.
+class PowerLightSampler : public LightSampler {
+ public:
+  explicit PowerLightSampler(
+      std::span<const std::shared_ptr<Primitive>> lights);
+
+  std::optional<SampledLight> Sample(const Point3& ref,
+                                     Float u) const override;
+  Float Pmf(const Point3& ref, size_t index) const override;
+
+ private:
+  AliasTable table_;
+};
+
+// The power a light primitive emits, up to the constant factor pi.
+Float LightPower(const Primitive& light);
+
+// Where a group of lights is, which way it faces and how much it emits.
+// Lights emit from both sides of their surface.
+struct LightBounds {
+  AABB bounds;
+  Vector3 w = Vector3(0, 0, 1);  // axis of the cone of surface normals
+  Float phi = 0;                 // power
+  Float cos_theta_o = 1;         // spread of the normals about w
+  Float cos_theta_e = 0;         // spread of the emission about a normal
+
+  static LightBounds Of(const Primitive& light);
+  // An upper bound on what the lights contribute at `p`, relative to other
+  // bounds: power over squared distance, times the cosine of the smallest
+  // angle any normal in the cone can make with the direction to `p`.
+  Float Importance(const Point3& p) const;
+};
+LightBounds Union(const LightBounds& a, const LightBounds& b);
+
+/**
+ * Light BVH (Conty Estevez & Kulla 2018)
+ * --------------------------------------
+ * A binary tree over the lights, each node storing the LightBounds of its
+ * subtree. Sampling descends from the root, choosing a child in proportion to
+ * its importance at the shading point, so nearby lights that face it are
+ * picked far more often than distant ones or ones facing away, and the cost
+ * is logarithmic in the number of lights. Pmf retraces the same descent from
+ * the path of left and right turns recorded for each light.
+ *
+ * Lights without power are left out and never chosen.
+ */
+class BvhLightSampler : public LightSampler {
+ public:
+  explicit BvhLightSampler(std::span<const std::shared_ptr<Primitive>> lights);
+
+  std::optional<SampledLight> Sample(const Point3& ref,
+                                     Float u) const override;
+  Float Pmf(const Point3& ref, size_t index) const override;
+
+ private:
+  struct Node {
+    LightBounds bounds;
+    // second child of an interior node, the first follows it; light index
+    // of a leaf
+    uint32_t index;
+    bool leaf;
+  };
+  struct BuildItem {
+    uint32_t light;
+    LightBounds bounds;
+  };
+  // returns the index of the subtree's root, `trail` holds the turns taken
+  // to reach it
+  uint32_t Build(std::span<BuildItem> items, uint64_t trail, int depth);
+  // probability of choosing the first child of interior node `node`, or
+  // nullopt if neither child matters at `ref`
+  std::optional<Float> FirstChildProbability(const Point3& ref,
+                                             uint32_t node) const;
+
+  std::vector<Node> nodes_;
+  // per light: a leading 1 followed by the turns from the root to its leaf,
+  // 1 for the second child; 0 for lights not in the tree
+  std::vector<uint64_t> trails_;
+};
+
+enum class LightSamplerType { Uniform, Power, Bvh };
+
+// Throws std::runtime_error on an unknown name.
+LightSamplerType ParseLightSamplerType(std::string_view name);
+std::unique_ptr<LightSampler> CreateLightSampler(
+    LightSamplerType type,
+    std::span<const std::shared_ptr<Primitive>> lights);
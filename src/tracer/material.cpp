@@ -21,6 +21,10 @@ BSDF DiffuseMaterial::GetBSDF(const HitRecord& rec) const {
       QuaternionTransform::RotateFrTo(Vector3(rec.normal), Vector3(0, 1, 0)));
 }
 
+Color DiffuseMaterial::Albedo(const HitRecord& rec) const {
+  return albedo_->Evaluate(rec.uv);
+}
+
 // ------------------------------------------------------------------------------
 ConductorMaterial::ConductorMaterial(Color color, Float uRough, Float vRough)
     : ConductorMaterial(make_texture(color),
@@ -42,6 +46,10 @@ BSDF ConductorMaterial::GetBSDF(const HitRecord& rec) const {
       QuaternionTransform::RotateFrTo(Vector3(rec.normal), Vector3(0, 1, 0)));
 }
 
+Color ConductorMaterial::Albedo(const HitRecord& rec) const {
+  return albedo_->Evaluate(rec.uv);
+}
+
 // ------------------------------------------------------------------------------
 DielectricMaterial::DielectricMaterial(Float eta, Float uRough, Float vRough)
     : DielectricMaterial(make_texture(eta),
@@ -63,14 +71,19 @@ BSDF DielectricMaterial::GetBSDF(const HitRecord& rec) const {
       QuaternionTransform::RotateFrTo(Vector3(rec.normal), Vector3(0, 1, 0)));
 }
 
+// clear glass
+Color DielectricMaterial::Albedo(const HitRecord&) const {
+  return Color(1);
+}
+
 // ------------------------------------------------------------------------------
 MixedMaterial::MixedMaterial(std::shared_ptr<IMaterial> first,
                              std::shared_ptr<IMaterial> second,
                              Float fac)
     : first_(std::move(first)), second_(std::move(second)), fac_(fac) {}
 
-std::shared_ptr<IMaterial> MixedMaterial::Select() const {
-  if (random_uniform_01() < fac_)
+std::shared_ptr<IMaterial> MixedMaterial::Select(Float u) const {
+  if (u < fac_)
     return first_;
   else
     return second_;
@@ -80,3 +93,7 @@ BSDF MixedMaterial::GetBSDF(const HitRecord&) const {
   spdlog::error("MixedMaterial::GetBSDF should not be called.");
   return BSDF(nullptr, QuaternionTransform(Quaternion(1, 0, 0, 0)));
 }
+
+Color MixedMaterial::Albedo(const HitRecord& rec) const {
+  return (1 - fac_) * first_->Albedo(rec) + fac_ * second_->Albedo(rec);
+}
@@ -13,6 +13,8 @@ class IMaterial {
   virtual ~IMaterial() = default;
 
   virtual BSDF GetBSDF(const HitRecord& rec) const = 0;
+  // The surface color at `rec`, as shown by the albedo AOV.
+  virtual Color Albedo(const HitRecord& rec) const = 0;
 };
 
 class DiffuseMaterial : public IMaterial {
@@ -23,6 +25,7 @@ class DiffuseMaterial : public IMaterial {
   DiffuseMaterial(Texture<Color> albedo);
 
   BSDF GetBSDF(const HitRecord& rec) const override;
+  Color Albedo(const HitRecord& rec) const override;
 };
 
 class ConductorMaterial : public IMaterial {
@@ -36,6 +39,7 @@ class ConductorMaterial : public IMaterial {
                     Texture<Float> vr);
 
   BSDF GetBSDF(const HitRecord& rec) const override;
+  Color Albedo(const HitRecord& rec) const override;
 };
 
 class DielectricMaterial : public IMaterial {
@@ -48,6 +52,7 @@ class DielectricMaterial : public IMaterial {
                      Texture<Float> vRough);
 
   BSDF GetBSDF(const HitRecord& rec) const override;
+  Color Albedo(const HitRecord& rec) const override;
 };
 
 class MixedMaterial : public IMaterial {
@@ -59,8 +64,11 @@ class MixedMaterial : public IMaterial {
                 std::shared_ptr<IMaterial> second,
                 Float fac);
 
-  std::shared_ptr<IMaterial> Select() const;
+  // picks one of the two by comparing u, uniform in [0, 1), against fac
+  std::shared_ptr<IMaterial> Select(Float u) const;
 
   // should not be called.
   BSDF GetBSDF(const HitRecord& rec) const override;
+  // blend of the two albedos by fac
+  Color Albedo(const HitRecord& rec) const override;
 };
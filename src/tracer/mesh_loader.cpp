@@ -0,0 +1,642 @@
+#include "mesh_loader.hpp"
+
+#include "util/mapped_file.hpp"
+#include "util/parallel.hpp"
+#include "util/util.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t kParallelGrain = 64 * 1024;
+
+std::vector<std::string_view> SplitWords(std::string_view line) {
+  std::vector<std::string_view> words;
+  size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() &&
+           std::isspace(static_cast<unsigned char>(line[i])))
+      ++i;
+    size_t j = i;
+    while (j < line.size() &&
+           !std::isspace(static_cast<unsigned char>(line[j])))
+      ++j;
+    if (j > i)
+      words.push_back(line.substr(i, j - i));
+    i = j;
+  }
+  return words;
+}
+
+// ---------- PLY -------------------------------------------------------------
+enum class PlyType {
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float32,
+  Float64
+};
+
+PlyType ParsePlyType(std::string_view s) {
+  if (s == "char" || s == "int8")
+    return PlyType::Int8;
+  if (s == "uchar" || s == "uint8")
+    return PlyType::UInt8;
+  if (s == "short" || s == "int16")
+    return PlyType::Int16;
+  if (s == "ushort" || s == "uint16")
+    return PlyType::UInt16;
+  if (s == "int" || s == "int32")
+    return PlyType::Int32;
+  if (s == "uint" || s == "uint32")
+    return PlyType::UInt32;
+  if (s == "float" || s == "float32")
+    return PlyType::Float32;
+  if (s == "double" || s == "float64")
+    return PlyType::Float64;
+  throw std::runtime_error(std::format("unknown PLY type '{}'", s));
+}
+
+size_t SizeOf(PlyType t) {
+  switch (t) {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+      return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+      return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+      return 4;
+    case PlyType::Float64:
+      return 8;
+  }
+  return 0;
+}
+
+template <typename T>
+T LoadRaw(const char* p, bool swap) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  if constexpr (sizeof(T) > 1) {
+    using U = std::conditional_t<
+        sizeof(T) == 2, uint16_t,
+        std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+    if (swap)
+      v = std::bit_cast<T>(std::byteswap(std::bit_cast<U>(v)));
+  }
+  return v;
+}
+
+// reads one scalar stored as `t` and converts it to T
+template <typename T>
+T LoadAs(const char* p, PlyType t, bool swap) {
+  switch (t) {
+    case PlyType::Int8:
+      return static_cast<T>(LoadRaw<int8_t>(p, swap));
+    case PlyType::UInt8:
+      return static_cast<T>(LoadRaw<uint8_t>(p, swap));
+    case PlyType::Int16:
+      return static_cast<T>(LoadRaw<int16_t>(p, swap));
+    case PlyType::UInt16:
+      return static_cast<T>(LoadRaw<uint16_t>(p, swap));
+    case PlyType::Int32:
+      return static_cast<T>(LoadRaw<int32_t>(p, swap));
+    case PlyType::UInt32:
+      return static_cast<T>(LoadRaw<uint32_t>(p, swap));
+    case PlyType::Float32:
+      return static_cast<T>(LoadRaw<float>(p, swap));
+    case PlyType::Float64:
+      return static_cast<T>(LoadRaw<double>(p, swap));
+  }
+  return T();
+}
+
+struct PlyProperty {
+  std::string name;
+  PlyType type;
+  bool is_list = false;
+  PlyType count_type = PlyType::UInt8;
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count;
+  std::vector<PlyProperty> props;
+};
+
+// bounds-checked read position in the binary body
+struct PlyCursor {
+  const char* p;
+  const char* end;
+
+  const char* Take(size_t n) {
+    if (static_cast<size_t>(end - p) < n)
+      throw std::runtime_error("unexpected end of PLY data");
+    const char* r = p;
+    p += n;
+    return r;
+  }
+  size_t Remaining() const { return static_cast<size_t>(end - p); }
+};
+
+std::shared_ptr<TriangleMesh> ParsePly(std::string_view data) {
+  // ---- header ----
+  std::vector<PlyElement> elements;
+  bool swap = false;
+  size_t pos = 0;
+  bool magic = false, ended = false;
+  while (!ended && pos < data.size()) {
+    size_t eol = data.find('\n', pos);
+    if (eol == std::string_view::npos)
+      break;
+    const auto words = SplitWords(data.substr(pos, eol - pos));
+    pos = eol + 1;
+    if (words.empty())
+      continue;
+
+    if (!magic) {
+      if (words[0] != "ply")
+        throw std::runtime_error("not a PLY file");
+      magic = true;
+    } else if (words[0] == "format") {
+      if (words.size() < 2)
+        throw std::runtime_error("malformed format line");
+      if (words[1] == "binary_little_endian")
+        swap = std::endian::native != std::endian::little;
+      else if (words[1] == "binary_big_endian")
+        swap = std::endian::native != std::endian::big;
+      else
+        throw std::runtime_error(
+            std::format("unsupported PLY format '{}', expected binary",
+                        words[1]));
+    } else if (words[0] == "element") {
+      if (words.size() < 3)
+        throw std::runtime_error("malformed element line");
+      PlyElement element{std::string(words[1]), 0, {}};
+      auto [ptr, ec] = std::from_chars(
+          words[2].data(), words[2].data() + words[2].size(), element.count);
+      if (ec != std::errc())
+        throw std::runtime_error("malformed element count");
+      elements.push_back(std::move(element));
+    } else if (words[0] == "property") {
+      if (elements.empty())
+        throw std::runtime_error("property before any element");
+      PlyProperty prop;
+      if (words.size() >= 5 && words[1] == "list") {
+        prop.is_list = true;
+        prop.count_type = ParsePlyType(words[2]);
+        prop.type = ParsePlyType(words[3]);
+        prop.name = words[4];
+      } else if (words.size() >= 3) {
+        prop.type = ParsePlyType(words[1]);
+        prop.name = words[2];
+      } else {
+        throw std::runtime_error("malformed property line");
+      }
+      elements.back().props.push_back(std::move(prop));
+    } else if (words[0] == "end_header") {
+      ended = true;
+    }
+  }
+  if (!ended)
+    throw std::runtime_error("missing end_header");
+
+  // ---- body ----
+  PlyCursor cur{data.data() + pos, data.data() + data.size()};
+  std::vector<Point3> positions;
+  std::vector<Normal> normals;
+  std::vector<Point2> uvs;
+  std::vector<uint32_t> indices;
+
+  for (const auto& element : elements) {
+    auto find = [&](std::initializer_list<std::string_view> names) {
+      for (size_t i = 0; i < element.props.size(); ++i)
+        for (auto name : names)
+          if (element.props[i].name == name)
+            return static_cast<int>(i);
+      return -1;
+    };
+
+    // every record takes at least its scalars and list counts, which bounds
+    // the header's count by the data left before anything is sized from it
+    size_t min_record = 0;
+    for (const auto& prop : element.props)
+      min_record += SizeOf(prop.is_list ? prop.count_type : prop.type);
+    if (min_record > 0 && element.count > cur.Remaining() / min_record)
+      throw std::runtime_error("element count exceeds file size");
+
+    if (element.name == "vertex") {
+      // fixed-size records, decoded in parallel straight from the mapping
+      std::vector<size_t> offset(element.props.size());
+      size_t record = 0;
+      for (size_t i = 0; i < element.props.size(); ++i) {
+        if (element.props[i].is_list)
+          throw std::runtime_error("list property in vertex element");
+        offset[i] = record;
+        record += SizeOf(element.props[i].type);
+      }
+      const char* block = cur.Take(element.count * record);
+
+      const int px = find({"x"}), py = find({"y"}), pz = find({"z"});
+      if (px < 0 || py < 0 || pz < 0)
+        throw std::runtime_error("vertex element without x/y/z");
+      const int nx = find({"nx"}), ny = find({"ny"}), nz = find({"nz"});
+      const int tu = find({"u", "s", "texture_u", "texture_s"});
+      const int tv = find({"v", "t", "texture_v", "texture_t"});
+      const bool has_normals = nx >= 0 && ny >= 0 && nz >= 0;
+      const bool has_uvs = tu >= 0 && tv >= 0;
+
+      positions.resize(element.count);
+      if (has_normals)
+        normals.resize(element.count, Normal(0, 0, 1));
+      if (has_uvs)
+        uvs.resize(element.count);
+
+      auto get = [&](const char* base, int prop) {
+        return LoadAs<Float>(base + offset[prop], element.props[prop].type,
+                             swap);
+      };
+      ParallelFor(
+          0, element.count,
+          [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+              const char* base = block + i * record;
+              positions[i] =
+                  Point3(get(base, px), get(base, py), get(base, pz));
+              if (has_normals)
+                normals[i] =
+                    Normal(get(base, nx), get(base, ny), get(base, nz));
+              if (has_uvs)
+                uvs[i] = Point2(get(base, tu), get(base, tv));
+            }
+          },
+          kParallelGrain);
+
+    } else if (element.name == "face") {
+      const int pi = find({"vertex_indices", "vertex_index"});
+      if (pi < 0 || !element.props[pi].is_list)
+        throw std::runtime_error("face element without vertex_indices list");
+      indices.reserve(3 * element.count);
+
+      for (size_t f = 0; f < element.count; ++f)
+        for (size_t k = 0; k < element.props.size(); ++k) {
+          const PlyProperty& prop = element.props[k];
+          if (!prop.is_list) {
+            cur.Take(SizeOf(prop.type));
+            continue;
+          }
+          const size_t n = LoadAs<size_t>(cur.Take(SizeOf(prop.count_type)),
+                                          prop.count_type, swap);
+          const size_t size = SizeOf(prop.type);
+          const char* list = cur.Take(n * size);
+          if (static_cast<int>(k) != pi || n < 3)
+            continue;
+
+          // fan triangulation of the polygon
+          const uint32_t v0 = LoadAs<uint32_t>(list, prop.type, swap);
+          for (size_t i = 1; i + 1 < n; ++i) {
+            indices.push_back(v0);
+            indices.push_back(
+                LoadAs<uint32_t>(list + i * size, prop.type, swap));
+            indices.push_back(
+                LoadAs<uint32_t>(list + (i + 1) * size, prop.type, swap));
+          }
+        }
+
+    } else {  // skip unknown elements
+      for (size_t r = 0; r < element.count; ++r)
+        for (const auto& prop : element.props) {
+          if (!prop.is_list) {
+            cur.Take(SizeOf(prop.type));
+            continue;
+          }
+          const size_t n = LoadAs<size_t>(cur.Take(SizeOf(prop.count_type)),
+                                          prop.count_type, swap);
+          cur.Take(n * SizeOf(prop.type));
+        }
+    }
+  }
+
+  return std::make_shared<TriangleMesh>(std::move(positions),
+                                        std::move(indices), std::move(normals),
+                                        std::move(uvs));
+}
+
+// ---------- OBJ -------------------------------------------------------------
+constexpr int64_t kNoIndex = std::numeric_limits<int64_t>::min();
+
+struct ObjCorner {
+  int64_t v[3] = {kNoIndex, kNoIndex, kNoIndex};  // position, uv, normal
+};
+
+// Everything parsed from one chunk of lines. Positive (absolute) indices are
+// stored 0-based; negative (relative) ones are resolved against the chunk's
+// own counts and listed in `relative` to be rebased once all chunks are done.
+struct ObjChunk {
+  std::vector<Point3> positions;
+  std::vector<Point2> uvs;
+  std::vector<Vector3> normals;
+  std::vector<ObjCorner> corners;
+  std::vector<uint32_t> face_sizes;
+  std::vector<std::pair<size_t, int>> relative;  // corner, attribute
+};
+
+class ObjLineParser {
+ public:
+  ObjLineParser(const char* p, const char* end) : p_(p), end_(end) {}
+
+  bool AtEnd() {
+    SkipSpaces();
+    return p_ == end_;
+  }
+
+  Float ParseFloat() {
+    SkipSpaces();
+    if (p_ != end_ && *p_ == '+')
+      ++p_;
+    Float value;
+    auto [ptr, ec] = std::from_chars(p_, end_, value);
+    if (ec != std::errc())
+      throw std::runtime_error("malformed number in OBJ file");
+    p_ = ptr;
+    return value;
+  }
+
+  // one "v", "v/vt", "v//vn" or "v/vt/vn" face corner, 1-based or negative
+  void ParseCorner(int64_t (&out)[3]) {
+    SkipSpaces();
+    for (int attr = 0; attr < 3; ++attr) {
+      if (attr > 0) {
+        if (p_ == end_ || *p_ != '/')
+          return;
+        ++p_;
+      }
+      if (p_ == end_ || *p_ == '/' || IsSpace(*p_))
+        continue;
+      auto [ptr, ec] = std::from_chars(p_, end_, out[attr]);
+      if (ec != std::errc() || out[attr] == 0)
+        throw std::runtime_error("malformed face index in OBJ file");
+      p_ = ptr;
+    }
+  }
+
+ private:
+  static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+  void SkipSpaces() {
+    while (p_ != end_ && IsSpace(*p_))
+      ++p_;
+  }
+
+  const char* p_;
+  const char* end_;
+};
+
+void ParseObjChunk(std::string_view text, ObjChunk& chunk) {
+  const char* p = text.data();
+  const char* const end = text.data() + text.size();
+  while (p < end) {
+    const char* eol =
+        static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr)
+      eol = end;
+    const char* line = p;
+    p = eol + (eol < end);
+
+    while (line < eol && (*line == ' ' || *line == '\t'))
+      ++line;
+    if (eol - line < 2 || line[0] == '#')
+      continue;
+
+    if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) {
+      ObjLineParser lp(line + 2, eol);
+      const Float x = lp.ParseFloat(), y = lp.ParseFloat(), z = lp.ParseFloat();
+      chunk.positions.emplace_back(x, y, z);
+    } else if (line[0] == 'v' && line[1] == 't') {
+      ObjLineParser lp(line + 2, eol);
+      const Float u = lp.ParseFloat();
+      const Float v = lp.AtEnd() ? 0 : lp.ParseFloat();
+      chunk.uvs.emplace_back(u, v);
+    } else if (line[0] == 'v' && line[1] == 'n') {
+      ObjLineParser lp(line + 2, eol);
+      const Float x = lp.ParseFloat(), y = lp.ParseFloat(), z = lp.ParseFloat();
+      chunk.normals.emplace_back(x, y, z);
+    } else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+      ObjLineParser lp(line + 2, eol);
+      const int64_t counts[3] = {
+          static_cast<int64_t>(chunk.positions.size()),
+          static_cast<int64_t>(chunk.uvs.size()),
+          static_cast<int64_t>(chunk.normals.size())};
+      uint32_t n = 0;
+      while (!lp.AtEnd()) {
+        ObjCorner corner;
+        lp.ParseCorner(corner.v);
+        if (corner.v[0] == kNoIndex)
+          throw std::runtime_error("face corner without a vertex index");
+        for (int attr = 0; attr < 3; ++attr) {
+          int64_t& idx = corner.v[attr];
+          if (idx == kNoIndex)
+            continue;
+          if (idx > 0) {
+            --idx;
+          } else {
+            idx += counts[attr];
+            chunk.relative.emplace_back(chunk.corners.size(), attr);
+          }
+        }
+        chunk.corners.push_back(corner);
+        ++n;
+      }
+      chunk.face_sizes.push_back(n);
+    }
+    // anything else (o, g, s, usemtl, mtllib, l, p, ...) is ignored
+  }
+}
+
+struct CornerHash {
+  size_t operator()(const ObjCorner& c) const noexcept {
+    size_t h = std::hash<int64_t>()(c.v[0]);
+    h = h * 0x9E3779B97F4A7C15ull ^ std::hash<int64_t>()(c.v[1]);
+    h = h * 0x9E3779B97F4A7C15ull ^ std::hash<int64_t>()(c.v[2]);
+    return h;
+  }
+};
+struct CornerEqual {
+  bool operator()(const ObjCorner& a, const ObjCorner& b) const noexcept {
+    return a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2];
+  }
+};
+
+std::shared_ptr<TriangleMesh> ParseObj(std::string_view data) {
+  // split at line boundaries into one chunk per thread
+  const size_t nchunks =
+      data.size() < kParallelGrain
+          ? 1
+          : std::min<size_t>(NumThreads(), data.size() / kParallelGrain);
+  std::vector<size_t> bounds(nchunks + 1, data.size());
+  bounds[0] = 0;
+  for (size_t i = 1; i < nchunks; ++i) {
+    size_t b = std::max(bounds[i - 1], data.size() * i / nchunks);
+    b = data.find('\n', b);
+    bounds[i] = b == std::string_view::npos ? data.size() : b + 1;
+  }
+
+  std::vector<ObjChunk> chunks(nchunks);
+  ParallelFor(0, nchunks, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      ParseObjChunk(data.substr(bounds[i], bounds[i + 1] - bounds[i]),
+                    chunks[i]);
+  });
+
+  // concatenate the vertex data and rebase relative indices
+  std::vector<Point3> positions;
+  std::vector<Point2> uvs;
+  std::vector<Vector3> normals;
+  for (auto& chunk : chunks) {
+    const int64_t base[3] = {static_cast<int64_t>(positions.size()),
+                             static_cast<int64_t>(uvs.size()),
+                             static_cast<int64_t>(normals.size())};
+    for (auto [corner, attr] : chunk.relative)
+      chunk.corners[corner].v[attr] += base[attr];
+    positions.insert(positions.end(), chunk.positions.begin(),
+                     chunk.positions.end());
+    uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+    normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+  }
+
+  const int64_t counts[3] = {static_cast<int64_t>(positions.size()),
+                             static_cast<int64_t>(uvs.size()),
+                             static_cast<int64_t>(normals.size())};
+  bool all_uv = true, all_normal = true, same_index = true;
+  for (const auto& chunk : chunks)
+    for (const auto& c : chunk.corners) {
+      for (int attr = 0; attr < 3; ++attr)
+        if (c.v[attr] != kNoIndex &&
+            (c.v[attr] < 0 || c.v[attr] >= counts[attr]))
+          throw std::runtime_error("face index out of range in OBJ file");
+      all_uv &= c.v[1] != kNoIndex;
+      all_normal &= c.v[2] != kNoIndex;
+      same_index &= (c.v[1] == kNoIndex || c.v[1] == c.v[0]) &&
+                    (c.v[2] == kNoIndex || c.v[2] == c.v[0]);
+    }
+  // attributes are only kept when every corner has them
+  const bool keep_uv = all_uv && !uvs.empty();
+  const bool keep_normal = all_normal && !normals.empty();
+
+  // Position indices can be used as is when no corner pairs a position with
+  // a different uv/normal slot. Otherwise every distinct corner becomes a
+  // vertex of its own.
+  const bool direct = same_index &&
+                      (!keep_uv || uvs.size() == positions.size()) &&
+                      (!keep_normal || normals.size() == positions.size());
+
+  std::vector<Point3> out_positions;
+  std::vector<Point2> out_uvs;
+  std::vector<Normal> out_normals;
+  std::vector<uint32_t> corner_vertex;
+  if (direct) {
+    out_positions = std::move(positions);
+    if (keep_uv)
+      out_uvs = std::move(uvs);
+    if (keep_normal) {
+      out_normals.reserve(normals.size());
+      for (const auto& it : normals)
+        out_normals.emplace_back(it);
+    }
+  } else {
+    std::unordered_map<ObjCorner, uint32_t, CornerHash, CornerEqual> vertex_of;
+    for (const auto& chunk : chunks)
+      for (ObjCorner c : chunk.corners) {
+        if (!keep_uv)
+          c.v[1] = kNoIndex;
+        if (!keep_normal)
+          c.v[2] = kNoIndex;
+        auto [it, inserted] = vertex_of.try_emplace(
+            c, static_cast<uint32_t>(out_positions.size()));
+        if (inserted) {
+          out_positions.push_back(positions[c.v[0]]);
+          if (keep_uv)
+            out_uvs.push_back(uvs[c.v[1]]);
+          if (keep_normal)
+            out_normals.emplace_back(normals[c.v[2]]);
+        }
+        corner_vertex.push_back(it->second);
+      }
+  }
+
+  // fan-triangulate the faces
+  std::vector<uint32_t> indices;
+  size_t corner_idx = 0;
+  for (const auto& chunk : chunks) {
+    size_t local = 0;
+    for (uint32_t n : chunk.face_sizes) {
+      auto vertex = [&](size_t k) {
+        return direct ? static_cast<uint32_t>(chunk.corners[local + k].v[0])
+                      : corner_vertex[corner_idx + k];
+      };
+      for (uint32_t k = 1; k + 1 < n; ++k) {
+        indices.push_back(vertex(0));
+        indices.push_back(vertex(k));
+        indices.push_back(vertex(k + 1));
+      }
+      local += n;
+      corner_idx += n;
+    }
+  }
+
+  return std::make_shared<TriangleMesh>(
+      std::move(out_positions), std::move(indices), std::move(out_normals),
+      std::move(out_uvs));
+}
+
+template <typename Parser>
+std::shared_ptr<TriangleMesh> LoadWith(const std::filesystem::path& path,
+                                       Parser parse) {
+  MappedFile file(path);
+  try {
+    return parse(file.View());
+  } catch (const std::runtime_error& e) {
+    throw std::runtime_error(std::format("{}: {}", path.string(), e.what()));
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<TriangleMesh> LoadPly(const std::filesystem::path& path) {
+  return LoadWith(path, ParsePly);
+}
+
+std::shared_ptr<TriangleMesh> LoadObj(const std::filesystem::path& path) {
+  return LoadWith(path, ParseObj);
+}
+
+std::shared_ptr<TriangleMesh> LoadMesh(const std::filesystem::path& path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (ext == ".ply")
+    return LoadPly(path);
+  if (ext == ".obj")
+    return LoadObj(path);
+  throw std::runtime_error(std::format(
+      "{}: unsupported mesh format '{}', expected .ply or .obj", path.string(),
+      ext));
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "shapes/2d/triangle_mesh.hpp"
+
+#include <filesystem>
+#include <memory>
+
+/**
+ * Mesh loaders
+ * ------------
+ *  - LoadPly reads binary (little or big endian) PLY. The file is
+ *    memory-mapped and the vertex/face arrays are decoded straight into the
+ *    mesh buffers.
+ *  - LoadObj reads Wavefront OBJ (v/vt/vn/f), parsing chunks of the file on
+ *    NumThreads() threads.
+ *  - Polygons are fan-triangulated.
+ *  - Throw std::runtime_error on unreadable or malformed input.
+ */
+std::shared_ptr<TriangleMesh> LoadPly(const std::filesystem::path& path);
+std::shared_ptr<TriangleMesh> LoadObj(const std::filesystem::path& path);
+
+/** Picks the loader by file extension, .ply or .obj. */
+std::shared_ptr<TriangleMesh> LoadMesh(const std::filesystem::path& path);
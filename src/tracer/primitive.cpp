@@ -21,6 +21,10 @@ HitRecord Primitive::Hit(Ray ray, Interval<Float> t) const {
   return rec;
 }
 
+bool Primitive::Intersects(const Ray& r, const Interval<Float>& t) const {
+  return shape_->Intersects(r, t);
+}
+
 AABB Primitive::GetBbox(void) const { return shape_->GetBbox(); }
 
 Color Primitive::Le(Ray r) const {
@@ -24,6 +24,7 @@ class Primitive {
                      std::shared_ptr<ILight> light);
 
   HitRecord Hit(Ray r, Interval<Float> t) const;
+  bool Intersects(const Ray& r, const Interval<Float>& t) const;
   AABB GetBbox(void) const;
   Color Le(Ray r) const;
 
@@ -0,0 +1,308 @@
+#include "sampler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+namespace {
+
+uint32_t ReverseBits32(uint32_t v) {
+  v = (v << 16) | (v >> 16);
+  v = ((v & 0x00ff00ff) << 8) | ((v & 0xff00ff00) >> 8);
+  v = ((v & 0x0f0f0f0f) << 4) | ((v & 0xf0f0f0f0) >> 4);
+  v = ((v & 0x33333333) << 2) | ((v & 0xcccccccc) >> 2);
+  v = ((v & 0x55555555) << 1) | ((v & 0xaaaaaaaa) >> 1);
+  return v;
+}
+
+// ---------------------------------------------------------------------------
+// Halton
+// ---------------------------------------------------------------------------
+
+// The first kPrimeCount primes, one Halton base per dimension. Paths that
+// need more dimensions wrap around.
+constexpr int kPrimeCount = 1000;
+constexpr std::array<uint32_t, kPrimeCount> kPrimes = []() {
+  std::array<uint32_t, kPrimeCount> primes{};
+  int count = 0;
+  for (uint32_t n = 2; count < kPrimeCount; ++n) {
+    bool is_prime = true;
+    for (int i = 0; i < count && primes[i] * primes[i] <= n; ++i)
+      if (n % primes[i] == 0) {
+        is_prime = false;
+        break;
+      }
+    if (is_prime)
+      primes[count++] = n;
+  }
+  return primes;
+}();
+
+// Radical inverse of `a` in the given base, where every digit is permuted
+// depending on the digits below it (Owen scrambling). Digits are generated
+// until they fall under 2^-32, which is plenty for sampling.
+Float OwenScrambledRadicalInverse(uint32_t base, uint64_t a, uint64_t hash) {
+  const Float inv_base = 1.0 / base;
+  uint64_t reversed = 0;
+  Float inv_base_m = 1;
+  while (inv_base_m > 0x1p-32) {
+    const uint64_t next = a / base;
+    const uint32_t digit = static_cast<uint32_t>(a - next * base);
+    const uint32_t digit_hash = static_cast<uint32_t>(MixBits(hash ^ reversed));
+    reversed = reversed * base + PermutationElement(digit, base, digit_hash);
+    inv_base_m *= inv_base;
+    a = next;
+  }
+  return std::min(reversed * inv_base_m, one_minus_epsilon);
+}
+
+// ---------------------------------------------------------------------------
+// Sobol
+// ---------------------------------------------------------------------------
+
+// Generator matrix of the second Sobol dimension (primitive polynomial x + 1),
+// column i as a 32-bit fraction. The first dimension is plain bit reversal.
+constexpr std::array<uint32_t, 32> kSobolMatrix1 = []() {
+  std::array<uint32_t, 32> m{};
+  m[0] = 1u << 31;
+  for (int i = 1; i < 32; ++i)
+    m[i] = m[i - 1] ^ (m[i - 1] >> 1);
+  return m;
+}();
+
+uint32_t SobolSample(uint32_t index, int dim) {
+  if (dim == 0)
+    return ReverseBits32(index);
+  uint32_t v = 0;
+  for (int i = 0; index != 0; index >>= 1, ++i)
+    if (index & 1)
+      v ^= kSobolMatrix1[i];
+  return v;
+}
+
+// Owen scrambling of a 32-bit fraction by a hash based on reversed-bit
+// multiplication (Laine and Karras 2011, improved constants by Vegdahl).
+uint32_t FastOwenScramble(uint32_t v, uint32_t seed) {
+  v = ReverseBits32(v);
+  v ^= v * 0x3d20adea;
+  v += seed;
+  v *= (seed >> 16) | 1;
+  v ^= v * 0x05526c56;
+  v ^= v * 0x53a22864;
+  return ReverseBits32(v);
+}
+
+// Index of the sample_index-th sample within its block of spp samples,
+// shuffled by `hash`. Later blocks of spp samples continue the sequence.
+uint32_t ShuffledIndex(int sample_index, int spp, uint64_t hash) {
+  const uint32_t n = static_cast<uint32_t>(spp);
+  const uint32_t i = static_cast<uint32_t>(sample_index);
+  return (i / n) * n +
+         PermutationElement(i % n, n, static_cast<uint32_t>(hash));
+}
+
+}  // namespace
+
+uint32_t PermutationElement(uint32_t i, uint32_t n, uint32_t seed) {
+  uint32_t w = n - 1;
+  w |= w >> 1;
+  w |= w >> 2;
+  w |= w >> 4;
+  w |= w >> 8;
+  w |= w >> 16;
+  // cycle-walk a hash that is a bijection on [0, w]
+  do {
+    i ^= seed;
+    i *= 0xe170893d;
+    i ^= seed >> 16;
+    i ^= (i & w) >> 4;
+    i ^= seed >> 8;
+    i *= 0x0929eb3f;
+    i ^= seed >> 23;
+    i ^= (i & w) >> 1;
+    i *= 1 | seed >> 27;
+    i *= 0x6935fa69;
+    i ^= (i & w) >> 11;
+    i *= 0x74dcb303;
+    i ^= (i & w) >> 2;
+    i *= 0x9e501cc3;
+    i ^= (i & w) >> 2;
+    i *= 0xc860a3df;
+    i &= w;
+    i ^= i >> 5;
+  } while (i >= n);
+  return (i + seed) % n;
+}
+
+// -----------------------------------------------------------------------------
+void IndependentSampler::StartPixelSample(int x,
+                                          int y,
+                                          int sample_index,
+                                          int dim) {
+  rng_.SetSequence(HashValues(static_cast<uint32_t>(x),
+                              static_cast<uint32_t>(y), seed_),
+                   0);
+  rng_.Advance(static_cast<uint64_t>(sample_index) * kMaxSampleDimensions +
+               dim);
+}
+
+Point2 IndependentSampler::Get2D() {
+  const Float u0 = rng_.Uniform01();
+  return Point2(u0, rng_.Uniform01());
+}
+
+std::unique_ptr<Sampler> IndependentSampler::Clone() const {
+  return std::make_unique<IndependentSampler>(*this);
+}
+
+// -----------------------------------------------------------------------------
+StratifiedSampler::StratifiedSampler(int spp, uint64_t seed)
+    : spp_(spp), seed_(seed) {
+  // the most square factorization nx * ny of spp
+  nx_ = static_cast<int>(std::sqrt(static_cast<double>(spp)));
+  while (nx_ > 1 && spp % nx_ != 0)
+    --nx_;
+  nx_ = std::max(nx_, 1);
+  ny_ = spp / nx_;
+}
+
+void StratifiedSampler::StartPixelSample(int x,
+                                         int y,
+                                         int sample_index,
+                                         int dim) {
+  x_ = x;
+  y_ = y;
+  sample_index_ = sample_index;
+  dim_ = dim;
+  // the jitter within each stratum
+  rng_.SetSequence(HashValues(static_cast<uint32_t>(x),
+                              static_cast<uint32_t>(y), seed_),
+                   0);
+  rng_.Advance(static_cast<uint64_t>(sample_index) * kMaxSampleDimensions +
+               dim);
+}
+
+uint64_t StratifiedSampler::DimensionHash() const {
+  return HashValues(static_cast<uint32_t>(x_), static_cast<uint32_t>(y_),
+                    static_cast<uint32_t>(dim_),
+                    static_cast<uint32_t>(sample_index_ / spp_), seed_);
+}
+
+Float StratifiedSampler::Get1D() {
+  const uint32_t stratum = PermutationElement(
+      sample_index_ % spp_, spp_, static_cast<uint32_t>(DimensionHash()));
+  ++dim_;
+  return std::min((stratum + rng_.Uniform01()) / spp_, one_minus_epsilon);
+}
+
+Point2 StratifiedSampler::Get2D() {
+  const uint32_t stratum = PermutationElement(
+      sample_index_ % spp_, spp_, static_cast<uint32_t>(DimensionHash()));
+  dim_ += 2;
+  const Float jx = rng_.Uniform01(), jy = rng_.Uniform01();
+  return Point2(std::min((stratum % nx_ + jx) / nx_, one_minus_epsilon),
+                std::min((stratum / nx_ + jy) / ny_, one_minus_epsilon));
+}
+
+std::unique_ptr<Sampler> StratifiedSampler::Clone() const {
+  return std::make_unique<StratifiedSampler>(*this);
+}
+
+// -----------------------------------------------------------------------------
+void HaltonSampler::StartPixelSample(int x, int y, int sample_index, int dim) {
+  x_ = x;
+  y_ = y;
+  sample_index_ = sample_index;
+  dim_ = dim;
+}
+
+Float HaltonSampler::Get1D() {
+  const uint64_t hash =
+      HashValues(static_cast<uint32_t>(x_), static_cast<uint32_t>(y_),
+                 static_cast<uint32_t>(dim_), seed_);
+  const uint32_t base = kPrimes[dim_ % kPrimeCount];
+  ++dim_;
+  return OwenScrambledRadicalInverse(base, sample_index_, hash);
+}
+
+Point2 HaltonSampler::Get2D() {
+  const Float u0 = Get1D();
+  return Point2(u0, Get1D());
+}
+
+std::unique_ptr<Sampler> HaltonSampler::Clone() const {
+  return std::make_unique<HaltonSampler>(*this);
+}
+
+// -----------------------------------------------------------------------------
+void SobolSampler::StartPixelSample(int x, int y, int sample_index, int dim) {
+  x_ = x;
+  y_ = y;
+  sample_index_ = sample_index;
+  dim_ = dim;
+}
+
+uint64_t SobolSampler::DimensionHash() const {
+  return HashValues(static_cast<uint32_t>(x_), static_cast<uint32_t>(y_),
+                    static_cast<uint32_t>(dim_), seed_);
+}
+
+Float SobolSampler::Get1D() {
+  const uint64_t hash = DimensionHash();
+  ++dim_;
+  const uint32_t index = ShuffledIndex(sample_index_, spp_, hash);
+  const uint32_t v = FastOwenScramble(SobolSample(index, 0),
+                                      static_cast<uint32_t>(hash >> 32));
+  return v * 0x1p-32;
+}
+
+Point2 SobolSampler::Get2D() {
+  const uint64_t hash = DimensionHash();
+  dim_ += 2;
+  const uint32_t index = ShuffledIndex(sample_index_, spp_, hash);
+  // a separate scramble per axis
+  const uint64_t axis_hash = MixBits(hash);
+  const uint32_t v0 = FastOwenScramble(SobolSample(index, 0),
+                                       static_cast<uint32_t>(axis_hash));
+  const uint32_t v1 = FastOwenScramble(SobolSample(index, 1),
+                                       static_cast<uint32_t>(axis_hash >> 32));
+  return Point2(v0 * 0x1p-32, v1 * 0x1p-32);
+}
+
+std::unique_ptr<Sampler> SobolSampler::Clone() const {
+  return std::make_unique<SobolSampler>(*this);
+}
+
+// -----------------------------------------------------------------------------
+SamplerType ParseSamplerType(std::string_view name) {
+  if (name == "independent")
+    return SamplerType::Independent;
+  if (name == "stratified")
+    return SamplerType::Stratified;
+  if (name == "halton")
+    return SamplerType::Halton;
+  if (name == "sobol")
+    return SamplerType::Sobol;
+  throw std::runtime_error(std::format("unknown sampler: {}", name));
+}
+
+std::unique_ptr<Sampler> CreateSampler(SamplerType type,
+                                       int spp,
+                                       uint64_t seed) {
+  if (spp <= 0)
+    throw std::runtime_error(
+        std::format("samples per pixel must be positive, got {}", spp));
+  switch (type) {
+    case SamplerType::Independent:
+      return std::make_unique<IndependentSampler>(spp, seed);
+    case SamplerType::Stratified:
+      return std::make_unique<StratifiedSampler>(spp, seed);
+    case SamplerType::Halton:
+      return std::make_unique<HaltonSampler>(spp, seed);
+    case SamplerType::Sobol:
+      return std::make_unique<SobolSampler>(spp, seed);
+  }
+  throw std::runtime_error("unknown sampler type");
+}
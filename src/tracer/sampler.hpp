@@ -0,0 +1,133 @@
+#pragma once
+
+#include "util/random.hpp"
+#include "util/util.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/**
+ * Sampler
+ * -------
+ * Supplies the random numbers of one path. A render thread calls
+ * StartPixelSample before each camera sample, then every consumer draws its
+ * own dimension(s) in a fixed order with Get1D/Get2D. Dimension d of sample i
+ * in a pixel is then a point of a well-distributed sequence over i, and the
+ * result depends only on (pixel, sample index, dimension, seed), never on the
+ * thread or the order pixels are rendered in.
+ *
+ * Samplers carry per-sample state, each thread works on its own Clone().
+ */
+class Sampler {
+ public:
+  virtual ~Sampler() = default;
+
+  virtual int SamplesPerPixel() const = 0;
+  virtual void StartPixelSample(int x,
+                                int y,
+                                int sample_index,
+                                int dim = 0) = 0;
+  // in [0, 1)
+  virtual Float Get1D() = 0;
+  virtual Point2 Get2D() = 0;
+
+  virtual std::unique_ptr<Sampler> Clone() const = 0;
+};
+
+// Uniform random numbers, no stratification at all.
+class IndependentSampler : public Sampler {
+ public:
+  explicit IndependentSampler(int spp, uint64_t seed = 0)
+      : spp_(spp), seed_(seed) {}
+
+  int SamplesPerPixel() const override { return spp_; }
+  void StartPixelSample(int x, int y, int sample_index, int dim) override;
+  Float Get1D() override { return rng_.Uniform01(); }
+  Point2 Get2D() override;
+
+  std::unique_ptr<Sampler> Clone() const override;
+
+ private:
+  int spp_;
+  uint64_t seed_;
+  PCG32 rng_;
+};
+
+// Jittered strata: spp strata per 1D dimension and an nx x ny grid per 2D
+// dimension, nx * ny = spp. The samples visit the strata in a pseudo-random
+// order that differs for every pixel and dimension.
+class StratifiedSampler : public Sampler {
+ public:
+  explicit StratifiedSampler(int spp, uint64_t seed = 0);
+
+  int SamplesPerPixel() const override { return spp_; }
+  void StartPixelSample(int x, int y, int sample_index, int dim) override;
+  Float Get1D() override;
+  Point2 Get2D() override;
+
+  std::unique_ptr<Sampler> Clone() const override;
+
+ private:
+  uint64_t DimensionHash() const;
+
+  int spp_, nx_, ny_;
+  uint64_t seed_;
+  int x_ = 0, y_ = 0, sample_index_ = 0, dim_ = 0;
+  PCG32 rng_;
+};
+
+// The Halton sequence, dimension d in base prime(d), Owen-scrambled per pixel
+// and dimension.
+class HaltonSampler : public Sampler {
+ public:
+  explicit HaltonSampler(int spp, uint64_t seed = 0)
+      : spp_(spp), seed_(seed) {}
+
+  int SamplesPerPixel() const override { return spp_; }
+  void StartPixelSample(int x, int y, int sample_index, int dim) override;
+  Float Get1D() override;
+  Point2 Get2D() override;
+
+  std::unique_ptr<Sampler> Clone() const override;
+
+ private:
+  int spp_;
+  uint64_t seed_;
+  int x_ = 0, y_ = 0, sample_index_ = 0, dim_ = 0;
+};
+
+// Padded Sobol: every 1D or 2D request uses the first Sobol dimension(s),
+// with the sample order shuffled and the points Owen-scrambled by a hash of
+// (pixel, dimension). Keeps the excellent 2D stratification of the leading
+// Sobol dimensions for every consumer. Best with power-of-two spp.
+class SobolSampler : public Sampler {
+ public:
+  explicit SobolSampler(int spp, uint64_t seed = 0) : spp_(spp), seed_(seed) {}
+
+  int SamplesPerPixel() const override { return spp_; }
+  void StartPixelSample(int x, int y, int sample_index, int dim) override;
+  Float Get1D() override;
+  Point2 Get2D() override;
+
+  std::unique_ptr<Sampler> Clone() const override;
+
+ private:
+  uint64_t DimensionHash() const;
+
+  int spp_;
+  uint64_t seed_;
+  int x_ = 0, y_ = 0, sample_index_ = 0, dim_ = 0;
+};
+
+enum class SamplerType { Independent, Stratified, Halton, Sobol };
+
+// Throws std::runtime_error on an unknown name.
+SamplerType ParseSamplerType(std::string_view name);
+std::unique_ptr<Sampler> CreateSampler(SamplerType type,
+                                       int spp,
+                                       uint64_t seed = 0);
+
+// The i-th element of a pseudo-random permutation of [0, n) selected by
+// `seed`, without building the permutation (Kensler 2013).
+uint32_t PermutationElement(uint32_t i, uint32_t n, uint32_t seed);
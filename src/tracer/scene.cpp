@@ -4,13 +4,29 @@
 #include <primitive.hpp>
 #include <util/util.hpp>
 
-Scene::Scene(std::vector<std::shared_ptr<Primitive>> objs)
-    : aggregator_(std::make_unique<BVT>(std::move(objs))) {}
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+Scene::Scene(std::vector<std::shared_ptr<Primitive>> objs, BVTOptions bvt_opt) {
+  const auto start = std::chrono::steady_clock::now();
+  aggregator_ = std::make_unique<BVT>(std::move(objs), std::move(bvt_opt));
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  spdlog::info("BVH built in {:.3f}s: {} nodes, SAH cost {:.3f}",
+               elapsed.count(), aggregator_->NodeCount(),
+               aggregator_->SahCost());
+}
 
 HitRecord Scene::Hit(Ray r, Interval<Float> time) const {
   return aggregator_->Hit(r, time);
 }
 
+bool Scene::Occluded(const Ray& ray, Float tmax) const {
+  return aggregator_->AnyHit(
+      ray, Interval<Float>(Interval<Float>::Positive().begin, tmax));
+}
+
 AABB Scene::GetBbox(void) const { return aggregator_->GetBbox(); }
 
 void Scene::SetBackground(std::function<Color(Ray)> fn) {
@@ -14,13 +14,16 @@ class AABB;
 
 class Scene {
  public:
-  Scene(std::vector<std::shared_ptr<Primitive>> objs);
+  Scene(std::vector<std::shared_ptr<Primitive>> objs,
+        BVTOptions bvt_opt = BVTOptions());
   ~Scene() = default;
 
   Scene(Scene&&) noexcept = default;
   Scene& operator=(Scene&&) noexcept = default;
 
   HitRecord Hit(Ray ray, Interval<Float> interval) const;
+  // Whether anything blocks `ray` before distance `tmax`, for shadow rays.
+  bool Occluded(const Ray& ray, Float tmax) const;
   AABB GetBbox(void) const;
   void SetBackground(std::function<Color(Ray)> fn);
   Color Background(Ray ray) const;
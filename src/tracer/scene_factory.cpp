@@ -3,12 +3,15 @@
 #include "light.hpp"
 #include "mapping.hpp"
 #include "material.hpp"
+#include "mesh_loader.hpp"
 #include "shapes/shape.hpp"
 #include "texture.hpp"
 
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <utility>
 
@@ -226,6 +229,16 @@ void SceneFactory::parse_lights(const json& array) {
   }
 }
 
+// ------------------------------------------------------------------------------
+void SceneFactory::add_mesh(std::shared_ptr<const TriangleMesh> mesh,
+                            std::shared_ptr<IMaterial> mat,
+                            std::shared_ptr<ILight> light) {
+  auto prims = TriangleMesh::CreatePrimitives(std::move(mesh), std::move(mat),
+                                              std::move(light));
+  objs_.insert(objs_.end(), std::make_move_iterator(prims.begin()),
+               std::make_move_iterator(prims.end()));
+}
+
 // ------------------------------------------------------------------------------
 void SceneFactory::parse_objects(const json& array) {
   constexpr std::string_view ctx = "objects";
@@ -240,9 +253,6 @@ void SceneFactory::parse_objects(const json& array) {
           ctx, "`type` must be string at object #" + std::to_string(idx));
     const std::string type_s = type.get<std::string>();
 
-    const json& v = it.at("data");
-    expect_array_size(v, 1, "object.data");
-
     /* -------- material / light lookup -------------------------------- */
     std::shared_ptr<IMaterial> mat = nullptr;
     std::shared_ptr<ILight> light = nullptr;
@@ -252,6 +262,27 @@ void SceneFactory::parse_objects(const json& array) {
     if (it.contains("light"))
       light = resolve_light(it["light"]);
 
+    // meshes stored in an external OBJ / PLY file
+    if (type_s == "mesh" && it.contains("path")) {
+      const json& path = it.at("path");
+      if (!path.is_string())
+        throw SCENE_ERROR(ctx, "mesh `path` must be string at object #" +
+                                   std::to_string(idx));
+      std::shared_ptr<const TriangleMesh> mesh;
+      try {
+        mesh = LoadMesh(path.get<std::string>());
+      } catch (const std::runtime_error& e) {
+        throw SCENE_ERROR(ctx, e.what());
+      }
+      spdlog::info("Loaded mesh '{}': {} triangles", path.get<std::string>(),
+                   mesh->TriangleCount());
+      add_mesh(std::move(mesh), std::move(mat), std::move(light));
+      continue;
+    }
+
+    const json& v = it.at("data");
+    expect_array_size(v, 1, "object.data");
+
     // shape construction
     if (type_s == "sphere") {
       expect_array_size(v, 4, "sphere data");
@@ -298,6 +329,56 @@ void SceneFactory::parse_objects(const json& array) {
       add_object(MakePrimitive<Parallelogram>(mat, light, o, a, c));
       add_object(MakePrimitive<Parallelogram>(mat, light, o, b, c));
 
+    } else if (type_s == "mesh") {
+      // data: flat vertex positions, indices: three per triangle,
+      // optional per-vertex "normals" (flat xyz) and "uvs" (flat uv)
+      expect_array_size(v, 9, "mesh data");
+      if (v.size() % 3 != 0)
+        throw SCENE_ERROR(ctx, "mesh data size must be a multiple of 3");
+      std::vector<Point3> positions;
+      positions.reserve(v.size() / 3);
+      for (std::size_t i = 0; i < v.size(); i += 3)
+        positions.push_back(parse_point3(v, i, "mesh.data"));
+
+      const json& idx_arr = it.at("indices");
+      expect_array_size(idx_arr, 3, "mesh indices");
+      if (idx_arr.size() % 3 != 0)
+        throw SCENE_ERROR(ctx, "mesh indices size must be a multiple of 3");
+      std::vector<uint32_t> indices;
+      indices.reserve(idx_arr.size());
+      for (const auto& i : idx_arr)
+        indices.push_back(expect_number<uint32_t>(i, "mesh.indices"));
+
+      std::vector<Normal> normals;
+      if (it.contains("normals")) {
+        const json& arr = it.at("normals");
+        expect_array_size(arr, 3, "mesh normals");
+        if (arr.size() % 3 != 0)
+          throw SCENE_ERROR(ctx, "mesh normals size must be a multiple of 3");
+        for (std::size_t i = 0; i < arr.size(); i += 3)
+          normals.emplace_back(parse_point3(arr, i, "mesh.normals"));
+      }
+      std::vector<Point2> uvs;
+      if (it.contains("uvs")) {
+        const json& arr = it.at("uvs");
+        expect_array_size(arr, 2, "mesh uvs");
+        if (arr.size() % 2 != 0)
+          throw SCENE_ERROR(ctx, "mesh uvs size must be a multiple of 2");
+        for (std::size_t i = 0; i < arr.size(); i += 2)
+          uvs.emplace_back(expect_number<Float>(arr[i], "mesh.uvs"),
+                           expect_number<Float>(arr[i + 1], "mesh.uvs"));
+      }
+
+      std::shared_ptr<const TriangleMesh> mesh;
+      try {
+        mesh = std::make_shared<TriangleMesh>(
+            std::move(positions), std::move(indices), std::move(normals),
+            std::move(uvs));
+      } catch (const std::runtime_error& e) {
+        throw SCENE_ERROR(ctx, e.what());
+      }
+      add_mesh(std::move(mesh), std::move(mat), std::move(light));
+
     } else {
       throw SCENE_ERROR(ctx, "unsupported shape '" + type_s + "' at object #" +
                                  std::to_string(idx));
@@ -402,11 +483,16 @@ Camera SceneFactory::CreateCamera() const {
   return parse_camera(root_.at("camera"));
 }
 
-Scene SceneFactory::CreateScene() {
-  if (root_.contains("objects"))
+Scene SceneFactory::CreateScene(BVTOptions bvt_opt) {
+  if (root_.contains("objects")) {
+    const auto start = std::chrono::steady_clock::now();
     parse_objects(root_.at("objects"));
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    spdlog::info("Parsed {} objects in {:.3f}s", objs_.size(), elapsed.count());
+  }
 
-  Scene scene(std::move(objs_));
+  Scene scene(std::move(objs_), std::move(bvt_opt));
 
   if (root_.contains("background")) {
     std::filesystem::path path = root_["background"].get<std::string>();
@@ -15,6 +15,7 @@
 
 template <typename T>
 class ITexture;
+class TriangleMesh;
 
 /**
  * SceneFactory
@@ -36,14 +37,17 @@ class SceneFactory {
   /** Build camera described in the JSON.  */
   [[nodiscard]] Camera CreateCamera() const;
 
-  /** Build full scene. */
-  [[nodiscard]] Scene CreateScene();
+  /** Build full scene, with the given BVH build settings. */
+  [[nodiscard]] Scene CreateScene(BVTOptions bvt_opt = BVTOptions());
 
  private:
   inline void add_object(std::shared_ptr<Primitive> o) {
     if (o != nullptr)
       objs_.emplace_back(o);
   }
+  void add_mesh(std::shared_ptr<const TriangleMesh> mesh,
+                std::shared_ptr<IMaterial> mat,
+                std::shared_ptr<ILight> light);
   static Camera parse_camera(const json& r);
 
   void parse_objects(const json& array);
@@ -1,24 +1,50 @@
 #include "shape.hpp"
 
+bool IShape::Intersects(const Ray& r, const Interval<Float>& t) const {
+  return Hit(r, t).hits;
+}
+
 Float IShape::Area() const { return 0; }
 
-ShapeSample IShape::Sample() const {
+DirectionCone IShape::NormalBounds() const {
+  return DirectionCone::EntireSphere();
+}
+
+ShapeSample IShape::Sample(Point2) const {
   ShapeSample sample;
   sample.pdf = 0;
   return sample;
 }
 
-Float IShape::Pdf(Point3 ref, Vector3 wo) const {
+ShapeSample IShape::Sample(const Point3& ref, Point2 u) const {
+  ShapeSample sample = Sample(u);
+  const Vector3 d = sample.pos - ref;
+  const Float d2 = d.Length_squared();
+  const Float cos = std::fabs(Vector3::Dot(sample.normal, d));
+  if (sample.pdf <= 0 || cos == 0) {
+    sample.pdf = 0;
+    return sample;
+  }
+  // dA = d^2 / cos dw
+  sample.pdf *= d2 * std::sqrt(d2) / cos;
+  return sample;
+}
+
+Float IShape::Pdf(const Point3& ref, const HitRecord& hit) const {
   const Float area = Area();
   if (area <= 0)
     return 0;
 
+  const Vector3 d = hit.position - ref;
+  const Float d2 = d.Length_squared();
+  const Float cos = std::fabs(Vector3::Dot(hit.normal, d)) / std::sqrt(d2);
+
+  return (1.0 / area) * d2 / cos;
+}
+
+Float IShape::Pdf(Point3 ref, Vector3 wo) const {
   HitRecord rec = Hit(Ray(ref, wo), Interval<Float>::Positive());
   if (!rec.hits)
     return 0;
-
-  const Float d2 = (rec.position - ref).Length_squared();
-  const Float cos = std::fabs(Vector3::Dot(rec.normal, wo));
-
-  return (1.0 / area) * d2 / cos;
+  return Pdf(ref, rec);
 }
@@ -2,6 +2,7 @@
 
 #include "hit_record.hpp"
 #include "util/aabb.hpp"
+#include "util/direction_cone.hpp"
 #include "util/ray.hpp"
 #include "util/transform.hpp"
 #include "util/vector.hpp"
@@ -21,10 +22,23 @@ class IShape {
   virtual ~IShape() = default;
 
   virtual HitRecord Hit(const Ray&, const Interval<Float>&) const = 0;
+  // Whether Hit would report an intersection, without filling in the record.
+  virtual bool Intersects(const Ray&, const Interval<Float>&) const;
   virtual AABB GetBbox() const = 0;
 
   virtual Float Area() const;
-  virtual ShapeSample Sample() const;
+  // a cone holding the surface normals
+  virtual DirectionCone NormalBounds() const;
+  // a point distributed over the surface, from a point of the unit square
+  virtual ShapeSample Sample(Point2 u) const;
+  // A point to light `ref` from, with its pdf per solid angle about `ref`,
+  // 0 if none could be found. Shapes that can, sample only the part of
+  // themselves `ref` sees; by default Sample(u) is converted.
+  virtual ShapeSample Sample(const Point3& ref, Point2 u) const;
 
+  // Solid angle density of Sample(ref, .) choosing `hit`, a point of this
+  // shape.
+  virtual Float Pdf(const Point3& ref, const HitRecord& hit) const;
+  // The same for the first point the ray (ref, wo) hits, 0 if it misses.
   Float Pdf(Point3 ref, Vector3 wo) const;
 };
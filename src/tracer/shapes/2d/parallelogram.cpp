@@ -3,13 +3,24 @@
 #include <util/util.hpp>
 
 #include <cmath>
+#include <optional>
 
 using namespace vec_helpers;
 
+namespace {
+// Below this the solid angle is computed with too much cancellation, and
+// sampling by area is just as good.
+constexpr Float kMinSolidAngle = 3e-4;
+}  // namespace
+
 Parallelogram::Parallelogram(Point3 o, Point3 a, Point3 b)
-    : trans_(MatrixTransformation::ChangeCoordinate(o, a, b)) {
-  Vector3 e1 = a - o, e2 = b - o;
-  area_ = IsParallel(e1, e2) ? 0.0 : Vector3::Cross(e1, e2).Length();
+    : trans_(MatrixTransformation::ChangeCoordinate(o, a, b)),
+      o_(o),
+      e1_(a - o),
+      e2_(b - o) {
+  area_ = IsParallel(e1_, e2_) ? 0.0 : Vector3::Cross(e1_, e2_).Length();
+  rectangle_ = area_ > 0 && std::abs(Vector3::Dot(e1_, e2_)) <=
+                                1e-9 * e1_.Length() * e2_.Length();
 }
 
 AABB Parallelogram::GetBbox() const {
@@ -21,32 +32,78 @@ inline static auto OnObject(Float a, Float b) {
   return 0 <= a && a <= 1 && 0 <= b && b <= 1;
 }
 
-HitRecord Parallelogram::Hit(const Ray& ray,
-                             const Interval<Float>& time_interval) const {
-  Ray r = ray.UndoTransform(trans_);
-
+// hit time of a ray in object space, if it crosses the shape within
+// `time_interval`
+inline static std::optional<Float> HitTime(
+    const Ray& r,
+    const Interval<Float>& time_interval) {
   const Float time = -r.Origin().y() / r.Direction().y();
   if (std::isnan(time))
-    return HitRecord();
+    return std::nullopt;
   if (!time_interval.Surrounds(time))
-    return HitRecord();
+    return std::nullopt;
 
   auto hit_point = r.At(time);
   if (!OnObject(hit_point.x(), hit_point.z()))
+    return std::nullopt;
+  return time;
+}
+
+HitRecord Parallelogram::Hit(const Ray& ray,
+                             const Interval<Float>& time_interval) const {
+  Ray r = ray.UndoTransform(trans_);
+  std::optional<Float> time = HitTime(r, time_interval);
+  if (!time.has_value())
     return HitRecord();
 
+  auto hit_point = r.At(*time);
   static const Normal normal{0, 1, 0};
-  return HitRecord::Create(time, ray.At(time),
+  return HitRecord::Create(*time, ray.At(*time),
                            Point2(hit_point.x(), hit_point.z()),
                            trans_.Doit(normal));
 }
 
-ShapeSample Parallelogram::Sample() const {
+bool Parallelogram::Intersects(const Ray& ray,
+                               const Interval<Float>& time_interval) const {
+  return HitTime(ray.UndoTransform(trans_), time_interval).has_value();
+}
+
+ShapeSample Parallelogram::Sample(Point2 u) const {
   ShapeSample sample;
   sample.pdf = 1.0 / area_;
-  sample.pos = trans_.Doit(Point3(random_uniform_01(), 0, random_uniform_01()));
+  sample.pos = trans_.Doit(Point3(u.x(), 0, u.y()));
+  sample.normal = trans_.Doit(Normal(0, 1, 0));
+  return sample;
+}
+
+std::optional<SphericalRectangle> Parallelogram::SolidAngleOf(
+    const Point3& ref) const {
+  if (!rectangle_)
+    return std::nullopt;
+  SphericalRectangle rect(ref, o_, e1_, e2_);
+  if (!(rect.SolidAngle() > kMinSolidAngle))
+    return std::nullopt;
+  return rect;
+}
+
+ShapeSample Parallelogram::Sample(const Point3& ref, Point2 u) const {
+  const auto rect = SolidAngleOf(ref);
+  if (!rect)
+    return IShape::Sample(ref, u);
+  ShapeSample sample;
+  sample.pos = rect->Sample(u);
   sample.normal = trans_.Doit(Normal(0, 1, 0));
+  sample.pdf = 1 / rect->SolidAngle();
   return sample;
 }
 
+Float Parallelogram::Pdf(const Point3& ref, const HitRecord& hit) const {
+  const auto rect = SolidAngleOf(ref);
+  return rect ? 1 / rect->SolidAngle() : IShape::Pdf(ref, hit);
+}
+
 Float Parallelogram::Area() const { return area_; }
+
+DirectionCone Parallelogram::NormalBounds() const {
+  return {Vector3(trans_.Doit(Normal(0, 1, 0))), 1};
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <shape.hpp>
+#include <util/sampling.hpp>
+
+#include <optional>
 
 struct Ray;
 class AABB;
@@ -13,10 +16,23 @@ class Parallelogram : public IShape {
 
   AABB GetBbox() const override;
   HitRecord Hit(const Ray&, const Interval<Float>&) const override;
-  ShapeSample Sample() const override;
+  bool Intersects(const Ray&, const Interval<Float>&) const override;
+  ShapeSample Sample(Point2 u) const override;
+  // uniform over the solid angle of a rectangle (SphericalRectangle), other
+  // parallelograms are sampled by area
+  ShapeSample Sample(const Point3& ref, Point2 u) const override;
+  Float Pdf(const Point3& ref, const HitRecord& hit) const override;
+  using IShape::Pdf;
   Float Area() const override;
+  DirectionCone NormalBounds() const override;
 
  private:
+  // the rectangle seen from `ref`, if it is one and not too small to sample
+  std::optional<SphericalRectangle> SolidAngleOf(const Point3& ref) const;
+
   MatrixTransformation trans_;
   Float area_;
+  Point3 o_;
+  Vector3 e1_, e2_;
+  bool rectangle_;
 };
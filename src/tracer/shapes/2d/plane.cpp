@@ -31,3 +31,10 @@ HitRecord Plane::Hit(const Ray& ray,
                            Point2(u - std::floor(u), v - std::floor(v)),
                            trans_.Doit(normal));
 }
+
+bool Plane::Intersects(const Ray& ray,
+                       const Interval<Float>& time_interval) const {
+  Ray r = ray.UndoTransform(trans_);
+  Float time = -r.Origin().y() / r.Direction().y();
+  return !std::isnan(time) && time_interval.Contains(time);
+}
@@ -9,6 +9,8 @@ class Plane : public IShape {
   AABB GetBbox(void) const override;
   HitRecord Hit(const Ray& ray,
                 const Interval<Float>& interval) const override;
+  bool Intersects(const Ray& ray,
+                  const Interval<Float>& interval) const override;
 
  private:
   MatrixTransformation trans_;
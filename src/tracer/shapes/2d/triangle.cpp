@@ -3,6 +3,7 @@
 #include <util/util.hpp>
 
 #include <cmath>
+#include <optional>
 
 using namespace vec_helpers;
 
@@ -21,30 +22,46 @@ inline static auto OnObject(Float a, Float b) {
   return (a + b) <= 1 && 0 <= a && 0 <= b;
 }
 
-HitRecord Triangle::Hit(const Ray& ray,
-                        const Interval<Float>& time_interval) const {
-  Ray r = ray.UndoTransform(trans_);
-
-  Float time = -r.Origin().y() / r.Direction().y();
+// hit time of a ray in object space, if it crosses the shape within
+// `time_interval`
+inline static std::optional<Float> HitTime(
+    const Ray& r,
+    const Interval<Float>& time_interval) {
+  const Float time = -r.Origin().y() / r.Direction().y();
   if (std::isnan(time))
-    return HitRecord();
+    return std::nullopt;
   if (!time_interval.Surrounds(time))
-    return HitRecord();
+    return std::nullopt;
 
   auto hit_point = r.At(time);
   if (!OnObject(hit_point.x(), hit_point.z()))
+    return std::nullopt;
+  return time;
+}
+
+HitRecord Triangle::Hit(const Ray& ray,
+                        const Interval<Float>& time_interval) const {
+  Ray r = ray.UndoTransform(trans_);
+  std::optional<Float> time = HitTime(r, time_interval);
+  if (!time.has_value())
     return HitRecord();
 
+  auto hit_point = r.At(*time);
   static const Normal normal{0, 1, 0};
-  return HitRecord::Create(time, ray.At(time),
+  return HitRecord::Create(*time, ray.At(*time),
                            Point2(hit_point.x(), hit_point.z()),
                            trans_.Doit(normal));
 }
 
-ShapeSample Triangle::Sample() const {
+bool Triangle::Intersects(const Ray& ray,
+                          const Interval<Float>& time_interval) const {
+  return HitTime(ray.UndoTransform(trans_), time_interval).has_value();
+}
+
+ShapeSample Triangle::Sample(Point2 u) const {
   ShapeSample sample;
   sample.pdf = 1.0 / area_;
-  Float a = random_uniform_01(), b = random_uniform_01();
+  Float a = u.x(), b = u.y();
   if (!OnObject(a, b)) {
     a = 1 - a;
     b = 1 - b;
@@ -55,3 +72,7 @@ ShapeSample Triangle::Sample() const {
 }
 
 Float Triangle::Area() const { return area_; }
+
+DirectionCone Triangle::NormalBounds() const {
+  return {Vector3(trans_.Doit(Normal(0, 1, 0))), 1};
+}
@@ -8,8 +8,10 @@ class Triangle : public IShape {
 
   AABB GetBbox() const override;
   HitRecord Hit(const Ray&, const Interval<Float>&) const override;
-  ShapeSample Sample() const override;
+  bool Intersects(const Ray&, const Interval<Float>&) const override;
+  ShapeSample Sample(Point2 u) const override;
   Float Area() const override;
+  DirectionCone NormalBounds() const override;
 
  private:
   MatrixTransformation trans_;
@@ -0,0 +1,174 @@
+#include "triangle_mesh.hpp"
+
+#include <primitive.hpp>
+#include <util/parallel.hpp>
+#include <util/util.hpp>
+
+#include <cmath>
+#include <format>
+#include <stdexcept>
+
+TriangleMesh::TriangleMesh(std::vector<Point3> positions,
+                           std::vector<uint32_t> indices,
+                           std::vector<Normal> normals,
+                           std::vector<Point2> uvs)
+    : positions_(std::move(positions)),
+      indices_(std::move(indices)),
+      normals_(std::move(normals)),
+      uvs_(std::move(uvs)) {
+  if (indices_.size() % 3 != 0)
+    throw std::runtime_error(
+        std::format("TriangleMesh: index count {} is not a multiple of 3",
+                    indices_.size()));
+  for (const auto& it : indices_)
+    if (it >= positions_.size())
+      throw std::runtime_error(
+          std::format("TriangleMesh: index {} out of range, {} vertices", it,
+                      positions_.size()));
+  if (!normals_.empty() && normals_.size() != positions_.size())
+    throw std::runtime_error("TriangleMesh: normals must match vertex count");
+  if (!uvs_.empty() && uvs_.size() != positions_.size())
+    throw std::runtime_error("TriangleMesh: uvs must match vertex count");
+}
+
+std::vector<std::shared_ptr<Primitive>> TriangleMesh::CreatePrimitives(
+    std::shared_ptr<const TriangleMesh> mesh,
+    std::shared_ptr<IMaterial> mat,
+    std::shared_ptr<ILight> light) {
+  std::vector<std::shared_ptr<Primitive>> result(mesh->TriangleCount());
+  ParallelFor(
+      0, result.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          result[i] = std::make_shared<Primitive>(
+              std::make_shared<MeshTriangle>(mesh, static_cast<uint32_t>(i)),
+              mat, light);
+      },
+      /*grain=*/16 * 1024);
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+MeshTriangle::MeshTriangle(std::shared_ptr<const TriangleMesh> mesh,
+                           uint32_t index)
+    : mesh_(std::move(mesh)), index_(index) {}
+
+AABB MeshTriangle::GetBbox() const { return AABB{P(0), P(1), P(2)}.Pad(); }
+
+std::optional<MeshTriangle::Intersection> MeshTriangle::Intersect(
+    const Ray& ray,
+    const Interval<Float>& time_interval) const {
+  // translate the vertices to the ray origin
+  Vector3 p0t = P(0) - ray.origin;
+  Vector3 p1t = P(1) - ray.origin;
+  Vector3 p2t = P(2) - ray.origin;
+
+  // permute so that the ray direction is largest along z
+  const Vector3& dir = ray.direction;
+  int kz = 0;
+  for (int a = 1; a < 3; ++a)
+    if (std::abs(dir[a]) > std::abs(dir[kz]))
+      kz = a;
+  const int kx = (kz + 1) % 3, ky = (kx + 1) % 3;
+  auto permute = [&](const Vector3& v) {
+    return Vector3(v[kx], v[ky], v[kz]);
+  };
+  const Vector3 d = permute(dir);
+  p0t = permute(p0t);
+  p1t = permute(p1t);
+  p2t = permute(p2t);
+
+  // shear so that the ray runs along +z
+  const Float sx = -d.x() / d.z(), sy = -d.y() / d.z(), sz = 1.0 / d.z();
+  auto shear = [&](const Vector3& v) {
+    return Vector3(v.x() + sx * v.z(), v.y() + sy * v.z(), v.z() * sz);
+  };
+  p0t = shear(p0t);
+  p1t = shear(p1t);
+  p2t = shear(p2t);
+
+  // Edge functions, a hit needs all of them to share one sign. Each edge is
+  // evaluated from its lower vertex index, so that the two triangles sharing
+  // it get exactly opposite values even if the products are fused into FMAs.
+  auto edge = [&](int i, int j, const Vector3& pi, const Vector3& pj) {
+    if (V(i) > V(j))
+      return -(pj.x() * pi.y() - pj.y() * pi.x());
+    return pi.x() * pj.y() - pi.y() * pj.x();
+  };
+  const Float e0 = edge(1, 2, p1t, p2t);
+  const Float e1 = edge(2, 0, p2t, p0t);
+  const Float e2 = edge(0, 1, p0t, p1t);
+  if ((e0 < 0 || e1 < 0 || e2 < 0) && (e0 > 0 || e1 > 0 || e2 > 0))
+    return std::nullopt;
+  const Float det = e0 + e1 + e2;
+  if (det == 0)
+    return std::nullopt;
+
+  // compare the scaled distance against the interval without dividing
+  const Float t_scaled = e0 * p0t.z() + e1 * p1t.z() + e2 * p2t.z();
+  if (det < 0 && (t_scaled >= time_interval.begin * det ||
+                  t_scaled <= time_interval.end * det))
+    return std::nullopt;
+  if (det > 0 && (t_scaled <= time_interval.begin * det ||
+                  t_scaled >= time_interval.end * det))
+    return std::nullopt;
+
+  const Float inv_det = 1.0 / det;
+  return Intersection{t_scaled * inv_det, e0 * inv_det, e1 * inv_det,
+                      e2 * inv_det};
+}
+
+HitRecord MeshTriangle::Hit(const Ray& ray,
+                            const Interval<Float>& time_interval) const {
+  std::optional<Intersection> isect = Intersect(ray, time_interval);
+  if (!isect.has_value())
+    return HitRecord();
+  const auto [time, b0, b1, b2] = *isect;
+
+  const Point3 position = P(0) + b1 * (P(1) - P(0)) + b2 * (P(2) - P(0));
+
+  Point2 uv(b1, b2);
+  if (const auto& uvs = mesh_->Uvs(); !uvs.empty()) {
+    const Point2 &uv0 = uvs[V(0)], &uv1 = uvs[V(1)], &uv2 = uvs[V(2)];
+    uv = Point2(b0 * uv0.x() + b1 * uv1.x() + b2 * uv2.x(),
+                b0 * uv0.y() + b1 * uv1.y() + b2 * uv2.y());
+  }
+
+  Normal normal(Vector3::Cross(P(1) - P(0), P(2) - P(0)));
+  if (const auto& normals = mesh_->Normals(); !normals.empty()) {
+    const Normal &n0 = normals[V(0)], &n1 = normals[V(1)], &n2 = normals[V(2)];
+    normal = Normal(b0 * n0.x() + b1 * n1.x() + b2 * n2.x(),
+                    b0 * n0.y() + b1 * n1.y() + b2 * n2.y(),
+                    b0 * n0.z() + b1 * n1.z() + b2 * n2.z());
+  }
+
+  return HitRecord::Create(time, position, uv, normal);
+}
+
+bool MeshTriangle::Intersects(const Ray& ray,
+                              const Interval<Float>& time_interval) const {
+  return Intersect(ray, time_interval).has_value();
+}
+
+ShapeSample MeshTriangle::Sample(Point2 u) const {
+  // uniform barycentrics by folding the unit square onto the triangle
+  Float b1 = u.x(), b2 = u.y();
+  if (b1 + b2 > 1) {
+    b1 = 1 - b1;
+    b2 = 1 - b2;
+  }
+
+  ShapeSample sample;
+  sample.pdf = 1.0 / Area();
+  sample.pos = P(0) + b1 * (P(1) - P(0)) + b2 * (P(2) - P(0));
+  sample.normal = Normal(Vector3::Cross(P(1) - P(0), P(2) - P(0)));
+  return sample;
+}
+
+DirectionCone MeshTriangle::NormalBounds() const {
+  return {Vector3::Cross(P(1) - P(0), P(2) - P(0)).Normalized(), 1};
+}
+
+Float MeshTriangle::Area() const {
+  return 0.5 * Vector3::Cross(P(1) - P(0), P(2) - P(0)).Length();
+}
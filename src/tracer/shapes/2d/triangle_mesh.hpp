@@ -0,0 +1,76 @@
+#pragma once
+
+#include <shape.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class Primitive;
+class IMaterial;
+class ILight;
+
+// Vertex and index buffers shared by all triangles of a mesh, in world
+// space. Triangle i uses the vertices indices[3i], indices[3i+1],
+// indices[3i+2]; `normals` and `uvs` are either empty or per vertex.
+class TriangleMesh {
+ public:
+  TriangleMesh(std::vector<Point3> positions,
+               std::vector<uint32_t> indices,
+               std::vector<Normal> normals = {},
+               std::vector<Point2> uvs = {});
+
+  inline size_t TriangleCount() const noexcept { return indices_.size() / 3; }
+  inline const std::vector<Point3>& Positions() const noexcept {
+    return positions_;
+  }
+  inline const std::vector<uint32_t>& Indices() const noexcept {
+    return indices_;
+  }
+  inline const std::vector<Normal>& Normals() const noexcept {
+    return normals_;
+  }
+  inline const std::vector<Point2>& Uvs() const noexcept { return uvs_; }
+
+  // One primitive per triangle, all sharing `mesh`, `mat` and `light`.
+  static std::vector<std::shared_ptr<Primitive>> CreatePrimitives(
+      std::shared_ptr<const TriangleMesh> mesh,
+      std::shared_ptr<IMaterial> mat,
+      std::shared_ptr<ILight> light);
+
+ private:
+  std::vector<Point3> positions_;
+  std::vector<uint32_t> indices_;
+  std::vector<Normal> normals_;
+  std::vector<Point2> uvs_;
+};
+
+// A single triangle of a TriangleMesh. Intersected in world space with the
+// watertight test of Woop et al., so rays never slip through shared edges.
+class MeshTriangle : public IShape {
+ public:
+  MeshTriangle(std::shared_ptr<const TriangleMesh> mesh, uint32_t index);
+
+  AABB GetBbox() const override;
+  HitRecord Hit(const Ray&, const Interval<Float>&) const override;
+  bool Intersects(const Ray&, const Interval<Float>&) const override;
+  ShapeSample Sample(Point2 u) const override;
+  Float Area() const override;
+  DirectionCone NormalBounds() const override;
+
+ private:
+  struct Intersection {
+    Float time;
+    Float b0, b1, b2;  // barycentric coordinates
+  };
+  std::optional<Intersection> Intersect(const Ray&,
+                                        const Interval<Float>&) const;
+
+  // vertex index and position of corner i
+  inline uint32_t V(int i) const { return mesh_->Indices()[3 * index_ + i]; }
+  inline const Point3& P(int i) const { return mesh_->Positions()[V(i)]; }
+
+  std::shared_ptr<const TriangleMesh> mesh_;
+  uint32_t index_;
+};
@@ -8,6 +8,11 @@
 #include <util/util.hpp>
 #include "spdlog/spdlog.h"
 
+namespace {
+// sin^2 of 1.5 degrees
+constexpr Float kSmallCone = 0.00068523;
+}  // namespace
+
 Sphere::Sphere(Point3 o, Float r)
     : trans_(o - Point3(0, 0, 0)),
       r_(r),
@@ -28,10 +33,9 @@ Point2 Sphere::GetUv(Point3 p) const {
   return Point2(phi / (2 * pi) + 0.5, theta / pi);
 }
 
-HitRecord Sphere::Hit(const Ray& ray,
-                      const Interval<Float>& time_interval) const {
-  Ray r = ray.UndoTransform(trans_);
-
+std::optional<Float> Sphere::NearestRoot(
+    const Ray& r,
+    const Interval<Float>& time_interval) const {
   Vector3 oc = (Vector3)r.Origin();
   Float a = r.Direction().Length_squared();
   Float b = Vector3::Dot(oc, r.Direction()) * 2;
@@ -39,7 +43,7 @@ HitRecord Sphere::Hit(const Ray& ray,
 
   Float discriminant = b * b - 4 * a * c;
   if (discriminant < 0)
-    return HitRecord();
+    return std::nullopt;
   Float sqrtd = std::sqrt(discriminant);
 
   // Find the nearest root that lies in the acceptable range.
@@ -47,10 +51,19 @@ HitRecord Sphere::Hit(const Ray& ray,
   if (!time_interval.Surrounds(root)) {
     root = (-b + sqrtd) / (2 * a);
     if (!time_interval.Surrounds(root))
-      return HitRecord();
+      return std::nullopt;
   }
+  return root;
+}
 
-  Float time = root;
+HitRecord Sphere::Hit(const Ray& ray,
+                      const Interval<Float>& time_interval) const {
+  Ray r = ray.UndoTransform(trans_);
+  std::optional<Float> root = NearestRoot(r, time_interval);
+  if (!root.has_value())
+    return HitRecord();
+
+  Float time = *root;
   Point3 position = r.At(time);
   Point2 uv = GetUv(position);
   Normal normal = Normal(position);
@@ -60,14 +73,79 @@ HitRecord Sphere::Hit(const Ray& ray,
   return HitRecord::Create(time, position, uv, normal);
 }
 
-ShapeSample Sphere::Sample() const {
+bool Sphere::Intersects(const Ray& ray,
+                        const Interval<Float>& time_interval) const {
+  return NearestRoot(ray.UndoTransform(trans_), time_interval).has_value();
+}
+
+ShapeSample Sphere::Sample(Point2 u) const {
   ShapeSample sample;
   sample.pdf = 1.0 / Area();
-  sample.pos = Point3(0, 0, 0) + rand_sphere_uniform();
+  sample.pos = Point3(0, 0, 0) + r_ * SampleUniformSphere(u);
   sample.normal = Normal(sample.pos);
   sample.pos = trans_.Doit(sample.pos);
   sample.normal = trans_.Doit(sample.normal);
   return sample;
 }
 
+std::optional<Sphere::Cone> Sphere::SubtendedCone(const Point3& ref) const {
+  const Float dist_sq = (trans_.Doit(Point3(0, 0, 0)) - ref).Length_squared();
+  if (dist_sq <= Sqr(r_))
+    return std::nullopt;
+  Cone cone;
+  cone.sin2_theta_max = Sqr(r_) / dist_sq;
+  cone.cos_theta_max = std::sqrt(std::max<Float>(1 - cone.sin2_theta_max, 0));
+  // 1 - cos loses all precision for tiny cones, use its Taylor series there
+  cone.one_minus_cos_theta_max = cone.sin2_theta_max < kSmallCone
+                                     ? cone.sin2_theta_max / 2
+                                     : 1 - cone.cos_theta_max;
+  return cone;
+}
+
+ShapeSample Sphere::Sample(const Point3& ref, Point2 u) const {
+  const auto cone = SubtendedCone(ref);
+  if (!cone)
+    return IShape::Sample(ref, u);
+
+  // direction within the cone, as the angle theta to its axis
+  Float cos_theta = (cone->cos_theta_max - 1) * u.x() + 1;
+  Float sin2_theta = 1 - Sqr(cos_theta);
+  if (cone->sin2_theta_max < kSmallCone) {
+    sin2_theta = cone->sin2_theta_max * u.x();
+    cos_theta = std::sqrt(1 - sin2_theta);
+  }
+  // and as the angle alpha at the center between the axis and the point hit
+  const Float sin_theta_max = std::sqrt(cone->sin2_theta_max);
+  const Float cos_alpha =
+      sin2_theta / sin_theta_max +
+      cos_theta * std::sqrt(std::max<Float>(
+                      1 - sin2_theta / cone->sin2_theta_max, 0));
+  const Float sin_alpha = std::sqrt(std::max<Float>(1 - Sqr(cos_alpha), 0));
+  const Float phi = 2 * pi * u.y();
+
+  // frame about the axis from the center back to ref
+  const Point3 center = trans_.Doit(Point3(0, 0, 0));
+  const Vector3 axis = (ref - center).Normalized();
+  const Vector3 t =
+      (std::abs(axis.x()) > 0.9 ? Vector3(0, 1, 0) : Vector3(1, 0, 0))
+          .Cross(axis)
+          .Normalized();
+  const Vector3 b = axis.Cross(t);
+  const Vector3 n = sin_alpha * std::cos(phi) * t +
+                    sin_alpha * std::sin(phi) * b + cos_alpha * axis;
+
+  ShapeSample sample;
+  sample.pos = center + r_ * n;
+  sample.normal = Normal(n);
+  sample.pdf = 1 / (2 * pi * cone->one_minus_cos_theta_max);
+  return sample;
+}
+
+Float Sphere::Pdf(const Point3& ref, const HitRecord& hit) const {
+  const auto cone = SubtendedCone(ref);
+  if (!cone)
+    return IShape::Pdf(ref, hit);
+  return 1 / (2 * pi * cone->one_minus_cos_theta_max);
+}
+
 Float Sphere::Area() const { return 4 * pi * Sqr(r_); }
@@ -3,6 +3,8 @@
 #include "shape.hpp"
 #include "util/transform.hpp"
 
+#include <optional>
+
 class Sphere : public IShape {
  public:
   Sphere(Point3 o, Float r);
@@ -11,7 +13,12 @@ class Sphere : public IShape {
 
   AABB GetBbox(void) const override;
   HitRecord Hit(const Ray& r, const Interval<Float>& time) const override;
-  ShapeSample Sample() const override;
+  bool Intersects(const Ray& r, const Interval<Float>& time) const override;
+  ShapeSample Sample(Point2 u) const override;
+  // uniform over the cone of directions the sphere covers, from outside
+  ShapeSample Sample(const Point3& ref, Point2 u) const override;
+  Float Pdf(const Point3& ref, const HitRecord& hit) const override;
+  using IShape::Pdf;
   Float Area() const override;
 
   // for testing
@@ -19,6 +26,15 @@ class Sphere : public IShape {
   inline auto r() const noexcept { return r_; }
 
  private:
+  // nearest root within `time` of a ray in object space
+  std::optional<Float> NearestRoot(const Ray& r,
+                                   const Interval<Float>& time) const;
+  struct Cone {
+    Float sin2_theta_max, cos_theta_max, one_minus_cos_theta_max;
+  };
+  // the cone the sphere covers from `ref`, nullopt from inside
+  std::optional<Cone> SubtendedCone(const Point3& ref) const;
+
   VectorTranslate trans_;
   Float r_;
   AABB bbox_;
@@ -3,4 +3,5 @@
 #include "2d/parallelogram.hpp"
 #include "2d/plane.hpp"
 #include "2d/triangle.hpp"
+#include "2d/triangle_mesh.hpp"
 #include "3d/sphere.hpp"
@@ -0,0 +1,101 @@
+#include "tile.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <string>
+
+TileOrder ParseTileOrder(std::string_view name) {
+  if (name == "scanline")
+    return TileOrder::Scanline;
+  if (name == "spiral")
+    return TileOrder::Spiral;
+  if (name == "hilbert")
+    return TileOrder::Hilbert;
+  throw std::runtime_error(std::format("unknown tile order: {}", name));
+}
+
+namespace {
+
+// Position of the d-th cell along a Hilbert curve over an n x n grid, n a
+// power of two.
+void HilbertToXY(unsigned n, unsigned d, unsigned& x, unsigned& y) {
+  x = y = 0;
+  for (unsigned s = 1; s < n; s *= 2) {
+    const unsigned rx = 1 & (d / 2);
+    const unsigned ry = 1 & (d ^ rx);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+    x += s * rx;
+    y += s * ry;
+    d /= 4;
+  }
+}
+
+}  // namespace
+
+std::vector<Tile> GenerateTiles(int width,
+                                int height,
+                                int tile_size,
+                                TileOrder order) {
+  if (tile_size <= 0)
+    throw std::runtime_error(std::format("invalid tile size {}", tile_size));
+  if (width <= 0 || height <= 0)
+    return {};
+
+  const int nx = (width + tile_size - 1) / tile_size;
+  const int ny = (height + tile_size - 1) / tile_size;
+  auto make_tile = [&](int tx, int ty) {
+    return Tile{tx * tile_size, ty * tile_size,
+                std::min((tx + 1) * tile_size, width),
+                std::min((ty + 1) * tile_size, height)};
+  };
+
+  std::vector<Tile> tiles;
+  tiles.reserve(static_cast<size_t>(nx) * ny);
+  switch (order) {
+    case TileOrder::Scanline:
+    case TileOrder::Spiral:
+      for (int ty = 0; ty < ny; ++ty)
+        for (int tx = 0; tx < nx; ++tx)
+          tiles.push_back(make_tile(tx, ty));
+      break;
+
+    case TileOrder::Hilbert: {
+      // walk the curve over the enclosing power-of-two grid and keep the
+      // cells that fall inside the image
+      const unsigned n = std::bit_ceil(static_cast<unsigned>(std::max(nx, ny)));
+      for (unsigned d = 0; d < n * n; ++d) {
+        unsigned tx, ty;
+        HilbertToXY(n, d, tx, ty);
+        if (tx < static_cast<unsigned>(nx) && ty < static_cast<unsigned>(ny))
+          tiles.push_back(make_tile(tx, ty));
+      }
+      break;
+    }
+  }
+
+  if (order == TileOrder::Spiral) {
+    // by square ring around the centre, then counter-clockwise within a ring
+    const double cx = 0.5 * width, cy = 0.5 * height;
+    auto key = [&](const Tile& t) {
+      const double dx = (0.5 * (t.x0 + t.x1) - cx) / tile_size;
+      const double dy = (0.5 * (t.y0 + t.y1) - cy) / tile_size;
+      return std::pair(std::round(std::max(std::abs(dx), std::abs(dy))),
+                       std::atan2(dy, dx));
+    };
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [&](const Tile& a, const Tile& b) {
+                       return key(a) < key(b);
+                     });
+  }
+
+  return tiles;
+}
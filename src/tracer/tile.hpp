@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Pixel rectangle [x0, x1) x [y0, y1).
+struct Tile {
+  int x0, y0, x1, y1;
+
+  int Width() const noexcept { return x1 - x0; }
+  int Height() const noexcept { return y1 - y0; }
+  int PixelCount() const noexcept { return Width() * Height(); }
+};
+
+enum class TileOrder {
+  Scanline,  // row by row, left to right
+  Spiral,    // rings around the image centre, outwards
+  Hilbert,   // along a Hilbert curve, neighbouring tiles stay close in memory
+};
+
+// Throws std::runtime_error on an unknown name.
+TileOrder ParseTileOrder(std::string_view name);
+
+// Covers the image with tile_size x tile_size tiles, clipped at the right and
+// bottom borders, listed in the given order.
+std::vector<Tile> GenerateTiles(int width,
+                                int height,
+                                int tile_size,
+                                TileOrder order = TileOrder::Scanline);
+
+/**
+ * Hands out tiles to render threads. Each call to Next() claims the next
+ * unclaimed tile with one atomic increment, so threads that draw cheap tiles
+ * simply come back for more and no thread idles while work is left.
+ */
+class TileScheduler {
+ public:
+  explicit TileScheduler(std::vector<Tile> tiles) : tiles_(std::move(tiles)) {}
+
+  // nullopt once every tile has been handed out
+  std::optional<Tile> Next() {
+    const size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+    if (i >= tiles_.size())
+      return std::nullopt;
+    return tiles_[i];
+  }
+
+  size_t Size() const noexcept { return tiles_.size(); }
+
+ private:
+  std::vector<Tile> tiles_;
+  std::atomic<size_t> next_ = 0;
+};
@@ -54,7 +54,7 @@ Float TrowbridgeReitzDistribution::PDF(Vector3 w, Vector3 wm) const {
   return D(w, wm);
 }
 
-Vector3 TrowbridgeReitzDistribution::Sample_wm(Vector3 w) const {
+Vector3 TrowbridgeReitzDistribution::Sample_wm(Vector3 w, Point2 u) const {
   // Hemispherical to ellipsoid transform
   Vector3 wh(alpha_x * w.x(), w.y(), alpha_z * w.z());
   wh = wh.Normalized();
@@ -68,7 +68,7 @@ Vector3 TrowbridgeReitzDistribution::Sample_wm(Vector3 w) const {
   Vector3 T2 = Vector3::Cross(wh, T1);
 
   // Sample disk
-  Point2 p = SampleUniformDiskPolar();
+  Point2 p = SampleUniformDiskPolar(u);
   Float h = std::sqrt(1 - Sqr(p.x()));
   p.y() = std::lerp(h, p.y(), (1 + wh.y()) / 2);
 
@@ -23,7 +23,7 @@ class TrowbridgeReitzDistribution {
   Float PDF(Vector3 w, Vector3 wm) const;
 
   // Sampling
-  Vector3 Sample_wm(Vector3 w) const;
+  Vector3 Sample_wm(Vector3 w, Point2 u) const;
 
   // Helpers
   static Float RoughnessToAlpha(Float roughness);
@@ -92,27 +92,22 @@ const Interval<Float>& AABB::Axis(const int& n) const {
 }
 
 bool AABB::isHitIn(const Ray& r, Interval<Float> ray_t) const {
-  for (int a = 0; a < 3; ++a) {
-    auto invD = 1.0 / r.Direction()[a];
-    auto orig = r.Origin()[a];
-
-    auto t0 = (Axis(a).begin - orig) * invD;
-    auto t1 = (Axis(a).end - orig) * invD;
-
-    if (invD < 0)
-      std::swap(t0, t1);
-
-    // Overlap the (a) component's interval [t0,t1]
-    // Let ray_t be the new effective time interval
-    if (t0 > ray_t.begin)
-      ray_t.begin = t0;
-    if (t1 < ray_t.end)
-      ray_t.end = t1;
+  return isHitIn(TraversalRay(r), ray_t);
+}
 
-    if (ray_t.end <= ray_t.begin)
-      return false;
+bool AABB::isHitIn(const TraversalRay& r, Interval<Float> ray_t) const {
+  const Interval<Float>* axes[3] = {&x_interval, &y_interval, &z_interval};
+  for (int a = 0; a < 3; ++a) {
+    const Float bounds[2] = {axes[a]->begin, axes[a]->end};
+    const Float t0 = (bounds[r.sign[a]] - r.origin[a]) * r.inv_dir[a];
+    const Float t1 = (bounds[1 - r.sign[a]] - r.origin[a]) * r.inv_dir[a];
+
+    // Overlap the (a) component's interval [t0,t1]. NaN slabs, from an
+    // origin on the plane of a parallel ray, leave ray_t as is.
+    ray_t.begin = t0 > ray_t.begin ? t0 : ray_t.begin;
+    ray_t.end = t1 < ray_t.end ? t1 : ray_t.end;
   }
-  return true;
+  return ray_t.begin < ray_t.end;
 }
 bool AABB::Contains(const Point3& p) const {
   const Float x = p.x(), y = p.y(), z = p.z();
@@ -141,6 +136,18 @@ AABB AABB::Pad() const {
   return AABB(xx, yy, zz);
 }
 
+Float AABB::SurfaceArea() const {
+  const Float dx = x_interval.Size(), dy = y_interval.Size(),
+              dz = z_interval.Size();
+  return 2 * (dx * dy + dy * dz + dz * dx);
+}
+
+Point3 AABB::Centroid() const {
+  return Point3(0.5 * (x_interval.begin + x_interval.end),
+                0.5 * (y_interval.begin + y_interval.end),
+                0.5 * (z_interval.begin + z_interval.end));
+}
+
 AABB AABB::Transform(const ITransformation& tr) const {
   std::array<Point3, 8> v{
       Point3(x_interval.begin, y_interval.begin, z_interval.begin),
@@ -8,6 +8,7 @@
 #include <ostream>
 
 struct Ray;
+struct TraversalRay;
 
 class AABB {
   // Approximate an visible object to a cube
@@ -36,11 +37,15 @@ class AABB {
 
   bool isEmpty() const;
   bool isHitIn(const Ray&, Interval<Float>) const;
+  bool isHitIn(const TraversalRay&, Interval<Float>) const;
   bool Contains(const Point3&) const;
   bool Contains(const AABB&) const;
 
   AABB Pad() const;
 
+  Float SurfaceArea() const;
+  Point3 Centroid() const;
+
   AABB Transform(const ITransformation&) const;
   AABB UndoTransform(const ITransformation&) const;
 
@@ -56,6 +56,11 @@ class Color : public basic_vector<Float, 3> {
     return *this = *this / rhs;
   }
 
+  // Rec. 709 relative luminance of a linear color
+  inline constexpr Float Luminance() const {
+    return 0.2126 * v[0] + 0.7152 * v[1] + 0.0722 * v[2];
+  }
+
   static constexpr Color Lerp(const Color& c1, const Color& c2, Float t) {
     return Color(std::lerp(c1.x(), c2.x(), t), std::lerp(c1.y(), c2.y(), t),
                  std::lerp(c1.z(), c2.z(), t));
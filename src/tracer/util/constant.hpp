@@ -9,3 +9,5 @@
 inline constexpr Float infinity = std::numeric_limits<Float>::infinity();
 inline constexpr Float pi = std::numbers::pi_v<Float>;
 inline constexpr Float invpi = static_cast<Float>(1.0) / pi;
+// largest Float below 1
+inline constexpr Float one_minus_epsilon = 0x1.fffffffffffffp-1;
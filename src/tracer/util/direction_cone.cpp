@@ -0,0 +1,67 @@
+#include "direction_cone.hpp"
+
+#include "util/constant.hpp"
+#include "util/util.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+Float SafeAcos(Float x) {
+  return std::acos(std::clamp<Float>(x, -1, 1));
+}
+
+// angle between unit vectors, accurate for nearly (anti)parallel ones
+Float AngleBetween(const Vector3& a, const Vector3& b) {
+  if (Vector3::Dot(a, b) < 0)
+    return pi - 2 * std::asin(std::min<Float>((a + b).Length() / 2, 1));
+  return 2 * std::asin(std::min<Float>((b - a).Length() / 2, 1));
+}
+
+// `v` rotated by `theta` about the unit vector `axis`, which is
+// perpendicular to it
+Vector3 RotatePerpendicular(const Vector3& v,
+                            const Vector3& axis,
+                            Float theta) {
+  return v * std::cos(theta) + Vector3::Cross(axis, v) * std::sin(theta);
+}
+}  // namespace
+
+DirectionCone Union(const DirectionCone& a, const DirectionCone& b) {
+  if (a.IsEmpty())
+    return b;
+  if (b.IsEmpty())
+    return a;
+
+  // keep either cone if it already holds the other
+  const Float theta_a = SafeAcos(a.cos_theta), theta_b = SafeAcos(b.cos_theta);
+  const Float theta_d = AngleBetween(a.w, b.w);
+  if (std::min(theta_d + theta_b, pi) <= theta_a)
+    return a;
+  if (std::min(theta_d + theta_a, pi) <= theta_b)
+    return b;
+
+  // otherwise the new cone spans from the far edge of a to that of b
+  const Float theta_o = (theta_a + theta_d + theta_b) / 2;
+  if (theta_o >= pi)
+    return DirectionCone::EntireSphere();
+  const Vector3 axis = Vector3::Cross(a.w, b.w);
+  if (axis.Length_squared() == 0)
+    return DirectionCone::EntireSphere();
+  const Vector3 w =
+      RotatePerpendicular(a.w, axis.Normalized(), theta_o - theta_a);
+  return {w.Normalized(), std::cos(theta_o)};
+}
+
+DirectionCone BoundSubtendedDirections(const AABB& box, const Point3& p) {
+  const Point3 center = box.Centroid();
+  const Float radius_sq = (Sqr(box.Axis(0).Size()) + Sqr(box.Axis(1).Size()) +
+                           Sqr(box.Axis(2).Size())) /
+                          4;
+  const Vector3 d = center - p;
+  const Float dist_sq = d.Length_squared();
+  if (dist_sq < radius_sq)
+    return DirectionCone::EntireSphere();
+  const Float sin_sq = radius_sq / dist_sq;
+  return {d / std::sqrt(dist_sq), std::sqrt(1 - sin_sq)};
+}
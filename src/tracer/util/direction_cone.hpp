@@ -0,0 +1,21 @@
+#pragma once
+
+#include "util/aabb.hpp"
+#include "util/vector.hpp"
+
+#include <limits>
+
+// The directions within angle theta of the unit vector `w`. Empty unless
+// cos_theta is at most 1.
+struct DirectionCone {
+  Vector3 w = Vector3(0, 0, 1);
+  Float cos_theta = std::numeric_limits<Float>::infinity();
+
+  static DirectionCone EntireSphere() { return {Vector3(0, 0, 1), -1}; }
+  bool IsEmpty() const { return cos_theta > 1; }
+};
+
+// the smallest cone around both cones
+DirectionCone Union(const DirectionCone& a, const DirectionCone& b);
+// the directions from `p` towards the bounding sphere of `box`
+DirectionCone BoundSubtendedDirections(const AABB& box, const Point3& p);
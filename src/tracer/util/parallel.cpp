@@ -0,0 +1,61 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<unsigned> num_threads = 0;
+}  // namespace
+
+unsigned NumThreads() {
+  unsigned n = num_threads.load(std::memory_order_relaxed);
+  if (n == 0)
+    n = std::thread::hardware_concurrency();
+  return n == 0 ? 4 : n;
+}
+
+void SetNumThreads(unsigned n) { num_threads = n; }
+
+void ParallelFor(std::size_t begin,
+                 std::size_t end,
+                 const std::function<void(std::size_t, std::size_t)>& body,
+                 std::size_t grain) {
+  if (end <= begin)
+    return;
+  const std::size_t count = end - begin;
+  grain = std::max<std::size_t>(grain, 1);
+  const std::size_t chunks =
+      std::min<std::size_t>(NumThreads(), (count + grain - 1) / grain);
+  if (chunks <= 1) {
+    body(begin, end);
+    return;
+  }
+
+  std::exception_ptr error;
+  std::mutex error_mtx;
+  auto run = [&](std::size_t b, std::size_t e) {
+    try {
+      body(b, e);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mtx);
+      if (!error)
+        error = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(chunks - 1);
+  for (std::size_t i = 1; i < chunks; ++i)
+    threads.emplace_back(run, begin + count * i / chunks,
+                         begin + count * (i + 1) / chunks);
+  run(begin, begin + count / chunks);
+  for (auto& t : threads)
+    t.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Number of worker threads used by the parallel loops below. Defaults to
+// std::thread::hardware_concurrency().
+unsigned NumThreads();
+// 0 restores the hardware default
+void SetNumThreads(unsigned n);
+
+/**
+ * Splits [begin, end) into contiguous chunks of at least `grain` items and
+ * runs `body(chunk_begin, chunk_end)` for each of them on up to NumThreads()
+ * threads. Returns once every chunk is done. An exception thrown by `body`
+ * is rethrown on the calling thread.
+ */
+void ParallelFor(std::size_t begin,
+                 std::size_t end,
+                 const std::function<void(std::size_t, std::size_t)>& body,
+                 std::size_t grain = 1);
@@ -1,23 +1,68 @@
-#include <random>
-
 #include "random.hpp"
 
-static std::mt19937 gen([] {
-  std::random_device rd;
-  return rd();
-}());
+#include <algorithm>
+#include <atomic>
+
+void PCG32::SetSequence(uint64_t seq_index, uint64_t seed) {
+  state_ = 0u;
+  inc_ = (seq_index << 1u) | 1u;
+  Uniform32();
+  state_ += seed;
+  Uniform32();
+}
+
+uint32_t PCG32::Uniform32() {
+  const uint64_t old = state_;
+  state_ = old * kMult + inc_;
+  const uint32_t xorshifted =
+      static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+  const uint32_t rot = static_cast<uint32_t>(old >> 59u);
+  return (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31));
+}
 
-Float random_uniform_01() {
-  static std::uniform_real_distribution<Float> distribution(0.0, 1.0);
-  return distribution(gen);
+void PCG32::Advance(uint64_t delta) {
+  // jump ahead by composing the LCG step with itself, Brown 1994
+  uint64_t cur_mult = kMult, cur_plus = inc_, acc_mult = 1u, acc_plus = 0u;
+  while (delta > 0) {
+    if (delta & 1) {
+      acc_mult *= cur_mult;
+      acc_plus = acc_plus * cur_mult + cur_plus;
+    }
+    cur_plus = (cur_mult + 1) * cur_plus;
+    cur_mult *= cur_mult;
+    delta /= 2;
+  }
+  state_ = acc_mult * state_ + acc_plus;
 }
 
+uint64_t MixBits(uint64_t v) {
+  // splitmix64 finalizer
+  v ^= v >> 31;
+  v *= 0x7fb5d329728ea185ULL;
+  v ^= v >> 27;
+  v *= 0x81dadef4bc2dd44dULL;
+  v ^= v >> 33;
+  return v;
+}
+
+namespace {
+// every thread gets a distinct stream
+std::atomic<uint64_t> next_thread_stream = 0;
+
+PCG32& ThreadRng() {
+  thread_local PCG32 rng(MixBits(next_thread_stream++), 0);
+  return rng;
+}
+}  // namespace
+
+Float random_uniform_01() { return ThreadRng().Uniform01(); }
+
 Float random_float(Float min, Float max) {
-  std::uniform_real_distribution<Float> distribution(min, max);
-  return distribution(gen);
+  return min + (max - min) * random_uniform_01();
 }
 
 int random_int(int min, int max) {
-  std::uniform_int_distribution<int> distribution(min, max);
-  return distribution(gen);
+  const auto range = static_cast<int64_t>(max) - min + 1;
+  const auto offset = static_cast<int64_t>(random_uniform_01() * range);
+  return static_cast<int>(min + std::min<int64_t>(offset, range - 1));
 }
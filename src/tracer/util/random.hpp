@@ -2,6 +2,46 @@
 
 #include "util/prshdefs.hpp"
 
+#include <cstdint>
+
+// PCG32 (O'Neill 2014): 64-bit LCG state with a permuted 32-bit output.
+// Streams are selected by the sequence index, and any position within a
+// stream can be reached in O(log n) with Advance.
+class PCG32 {
+ public:
+  PCG32() : state_(kDefaultState), inc_(kDefaultStream) {}
+  PCG32(uint64_t seq_index, uint64_t seed) { SetSequence(seq_index, seed); }
+
+  void SetSequence(uint64_t seq_index, uint64_t seed);
+  void Advance(uint64_t delta);
+
+  uint32_t Uniform32();
+  // in [0, 1)
+  Float Uniform01() { return Uniform32() * 0x1p-32; }
+
+ private:
+  static constexpr uint64_t kDefaultState = 0x853c49e6748fea9bULL;
+  static constexpr uint64_t kDefaultStream = 0xda3e39cb94b95bdbULL;
+  static constexpr uint64_t kMult = 0x5851f42d4c957f2dULL;
+
+  uint64_t state_, inc_;
+};
+
+// Mixes the bits of its arguments into one well-distributed 64-bit value.
+uint64_t MixBits(uint64_t v);
+template <typename... Ts>
+inline uint64_t HashValues(uint64_t first, Ts... rest) {
+  uint64_t h = MixBits(first);
+  ((h = MixBits(h ^ static_cast<uint64_t>(rest))), ...);
+  return h;
+}
+
+// Samplers that draw from a PCG32 stream per pixel give each sample this
+// many dimensions of the stream, so a sample's values depend only on (pixel,
+// sample index, seed) and not on which thread renders it.
+inline constexpr uint64_t kMaxSampleDimensions = 1 << 16;
+
+// Draws from the calling thread's own generator, so there is no shared state.
 Float random_uniform_01();
 
 Float random_float(Float min, Float max);
@@ -10,6 +10,15 @@ Ray Ray::Transform(const ITransformation& tr) const {
   return Ray(tr.Doit(Origin()), tr.Doit(Direction()));
 }
 
+TraversalRay::TraversalRay(const Ray& r)
+    : origin(r.origin),
+      inv_dir(1.0 / r.direction.x(),
+              1.0 / r.direction.y(),
+              1.0 / r.direction.z()) {
+  for (int a = 0; a < 3; ++a)
+    sign[a] = std::signbit(inv_dir[a]) ? 1 : 0;
+}
+
 Ray Ray::UndoTransform(const ITransformation& tr) const {
   return Ray(tr.Undo(Origin()), tr.Undo(Direction()));
 }
@@ -42,3 +42,14 @@ struct Ray {
 };
 
 static_assert(Transformable<Ray>);
+
+// Per-ray constants of the slab test, computed once before a traversal.
+// `sign[a]` is 1 where the direction is negative, so that bounds[sign[a]] is
+// the near plane and bounds[1 - sign[a]] the far plane on axis a.
+struct TraversalRay {
+  explicit TraversalRay(const Ray& r);
+
+  Point3 origin;
+  Vector3 inv_dir;
+  int sign[3];
+};
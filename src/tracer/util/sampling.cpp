@@ -3,6 +3,10 @@
 #include <util/random.hpp>
 #include <util/vector.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 Float pdf_cosine_distributed_hemisphere(const Vector3& wo) {
   const Float len_sq = wo.Length_squared();
   if (len_sq == 0)
@@ -13,8 +17,8 @@ Float pdf_cosine_distributed_hemisphere(const Vector3& wo) {
   return costheta * invpi;
 }
 
-Vector3 Spawn_cosine_distributed_hemisphere() {
-  Float r1 = random_uniform_01(), r2 = random_uniform_01();
+Vector3 Spawn_cosine_distributed_hemisphere(Point2 u) {
+  Float r1 = u.x(), r2 = u.y();
   Float phi = r1 * 2 * pi;
 
   Float dx = cos(phi) * std::sqrt(r2);
@@ -23,3 +27,103 @@ Vector3 Spawn_cosine_distributed_hemisphere() {
 
   return Vector3{dx, dy, dz};
 }
+
+AliasTable::AliasTable(std::span<const Float> weights)
+    : bins_(weights.size()) {
+  const size_t n = weights.size();
+  const Float sum = std::accumulate(weights.begin(), weights.end(), Float(0));
+  for (size_t i = 0; i < n; ++i)
+    bins_[i].pmf = sum > 0 ? weights[i] / sum : Float(1) / n;
+
+  // split the bins into those under and over the average 1/n, then let every
+  // under-full bin borrow the rest of its slot from an over-full one
+  std::vector<size_t> under, over;
+  std::vector<Float> scaled(n);
+  for (size_t i = 0; i < n; ++i) {
+    scaled[i] = bins_[i].pmf * n;
+    (scaled[i] < 1 ? under : over).push_back(i);
+  }
+  while (!under.empty() && !over.empty()) {
+    const size_t u = under.back(), o = over.back();
+    under.pop_back();
+    bins_[u].q = scaled[u];
+    bins_[u].alias = static_cast<uint32_t>(o);
+    scaled[o] -= 1 - scaled[u];
+    if (scaled[o] < 1) {
+      over.pop_back();
+      under.push_back(o);
+    }
+  }
+  // whatever is left is full up to rounding
+  for (size_t i : under)
+    bins_[i].q = 1;
+  for (size_t i : over)
+    bins_[i].q = 1;
+}
+
+size_t AliasTable::Sample(Float u) const {
+  const Float un = u * bins_.size();
+  const size_t i = std::min<size_t>(un, bins_.size() - 1);
+  // the fraction of u within its slot picks between the bin and its alias
+  return un - i < bins_[i].q ? i : bins_[i].alias;
+}
+
+SphericalRectangle::SphericalRectangle(const Point3& ref,
+                                       const Point3& s,
+                                       const Vector3& ex,
+                                       const Vector3& ey)
+    : ref_(ref) {
+  const Float ex_len = ex.Length(), ey_len = ey.Length();
+  x_ = ex / ex_len;
+  y_ = ey / ey_len;
+  z_ = Vector3::Cross(x_, y_);
+  const Vector3 d = s - ref;
+  x0_ = Vector3::Dot(d, x_);
+  y0_ = Vector3::Dot(d, y_);
+  z0_ = Vector3::Dot(d, z_);
+  if (z0_ > 0) {
+    z_ = -z_;
+    z0_ = -z0_;
+  }
+  x1_ = x0_ + ex_len;
+  y1_ = y0_ + ey_len;
+
+  // normals of the planes through ref and each edge, and the angles between
+  // them, which sum to the area of the spherical quad plus 2 pi
+  const Vector3 v00(x0_, y0_, z0_), v01(x0_, y1_, z0_);
+  const Vector3 v10(x1_, y0_, z0_), v11(x1_, y1_, z0_);
+  const Vector3 n0 = Vector3::Cross(v00, v10).Normalized();
+  const Vector3 n1 = Vector3::Cross(v10, v11).Normalized();
+  const Vector3 n2 = Vector3::Cross(v11, v01).Normalized();
+  const Vector3 n3 = Vector3::Cross(v01, v00).Normalized();
+  auto angle = [](const Vector3& a, const Vector3& b) {
+    return std::acos(std::clamp<Float>(-Vector3::Dot(a, b), -1, 1));
+  };
+  const Float g0 = angle(n0, n1), g1 = angle(n1, n2);
+  const Float g2 = angle(n2, n3), g3 = angle(n3, n0);
+  b0_ = n0.z();
+  b1_ = n2.z();
+  k_ = 2 * pi - g2 - g3;
+  solid_angle_ = g0 + g1 - k_;
+  if (!(solid_angle_ > 0))
+    solid_angle_ = 0;
+}
+
+Point3 SphericalRectangle::Sample(Point2 u) const {
+  // the x at which the sub-rectangle [x0, x] covers u.x of the solid angle
+  const Float au = u.x() * solid_angle_ + k_;
+  const Float fu = (std::cos(au) * b0_ - b1_) / std::sin(au);
+  Float cu = std::copysign(1 / std::sqrt(fu * fu + b0_ * b0_), fu);
+  cu = std::clamp<Float>(cu, -one_minus_epsilon, one_minus_epsilon);
+  const Float xu =
+      std::clamp<Float>(-cu * z0_ / std::sqrt(1 - cu * cu), x0_, x1_);
+
+  // then y uniform in the sine of the elevation along that line
+  const Float d = std::sqrt(xu * xu + z0_ * z0_);
+  const Float h0 = y0_ / std::sqrt(d * d + y0_ * y0_);
+  const Float h1 = y1_ / std::sqrt(d * d + y1_ * y1_);
+  const Float hv = h0 + u.y() * (h1 - h0);
+  const Float yv = hv * hv < 1 - 1e-6 ? hv * d / std::sqrt(1 - hv * hv) : y1_;
+
+  return ref_ + xu * x_ + yv * y_ + z0_ * z_;
+}
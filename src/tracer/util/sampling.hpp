@@ -4,9 +4,14 @@
 #include "util/random.hpp"
 #include "util/vector.hpp"
 
+#include <cstdint>
+#include <span>
+#include <vector>
+
 Float pdf_cosine_distributed_hemisphere(const Vector3& wo);
 
-Vector3 Spawn_cosine_distributed_hemisphere();
+// cosine-weighted direction about +y from a point of the unit square
+Vector3 Spawn_cosine_distributed_hemisphere(Point2 u);
 
 inline static Vector3 rand_hemisphere_uniform() {
   Float u1 = random_uniform_01();
@@ -20,11 +25,11 @@ inline static Vector3 rand_hemisphere_uniform() {
   return Vector3{x, y, z};
 }
 
-inline static Vector3 rand_sphere_uniform() {
+inline Vector3 SampleUniformSphere(Point2 u) {
   // u1 → controls z coordinate in [-1,1]
   // u2 → controls azimuth around the z-axis
-  Float u1 = random_uniform_01();
-  Float u2 = random_uniform_01();
+  Float u1 = u.x();
+  Float u2 = u.y();
   Float z = 1.0 - 2.0 * u1;                         // Uniform in [-1,1]
   Float r = std::sqrt(std::max(0.0, 1.0 - z * z));  // Radius in xy-plane
   Float phi = 2.0 * pi * u2;                        // Uniform in [0,2pi)
@@ -35,9 +40,73 @@ inline static Vector3 rand_sphere_uniform() {
   return Vector3{x, y, z};
 }
 
-inline Point2 SampleUniformDiskPolar() {
-  Float u0 = random_uniform_01(), u1 = random_uniform_01();
+inline static Point2 rand_point2() {
+  const Float u0 = random_uniform_01();
+  return Point2(u0, random_uniform_01());
+}
+
+inline static Vector3 rand_sphere_uniform() {
+  return SampleUniformSphere(rand_point2());
+}
+
+inline Point2 SampleUniformDiskPolar(Point2 u) {
+  Float u0 = u.x(), u1 = u.y();
   Float r = std::sqrt(u0);
   Float theta = 2 * pi * u1;
   return Point2{r * std::cos(theta), r * std::sin(theta)};
 }
+
+/**
+ * AliasTable
+ * ----------
+ * Draws index i with probability weights[i] / sum(weights) in O(1), from one
+ * uniform number (Vose's alias method). All-zero weights fall back to a
+ * uniform choice.
+ */
+class AliasTable {
+ public:
+  AliasTable() = default;
+  explicit AliasTable(std::span<const Float> weights);
+
+  // u in [0, 1)
+  size_t Sample(Float u) const;
+  Float Pmf(size_t i) const { return bins_[i].pmf; }
+  size_t Size() const noexcept { return bins_.size(); }
+
+ private:
+  struct Bin {
+    Float q;    // probability of keeping the bin's own index
+    Float pmf;  // of the index itself
+    uint32_t alias;
+  };
+  std::vector<Bin> bins_;
+};
+
+/**
+ * SphericalRectangle (Urena et al. 2013)
+ * --------------------------------------
+ * A rectangle with corner `s` and perpendicular edges `ex`, `ey` as seen
+ * from `ref`. Sample gives points of the rectangle whose directions from
+ * `ref` are uniformly distributed over the solid angle it covers, so the pdf
+ * is 1 / SolidAngle().
+ */
+class SphericalRectangle {
+ public:
+  SphericalRectangle(const Point3& ref,
+                     const Point3& s,
+                     const Vector3& ex,
+                     const Vector3& ey);
+
+  Float SolidAngle() const noexcept { return solid_angle_; }
+  // u in [0, 1)^2, needs a positive solid angle
+  Point3 Sample(Point2 u) const;
+
+ private:
+  Point3 ref_;
+  // frame with z pointing away from the rectangle
+  Vector3 x_, y_, z_;
+  // the rectangle in that frame: [x0, x1] x [y0, y1] at depth z0 < 0
+  Float x0_, x1_, y0_, y1_, z0_;
+  Float b0_, b1_, k_;
+  Float solid_angle_;
+};
@@ -0,0 +1,127 @@
+#include "wavefront.hpp"
+
+#include "bsdf.hpp"
+#include "integrator.hpp"
+#include "material.hpp"
+#include "primitive.hpp"
+#include "scene.hpp"
+
+#include <algorithm>
+
+void Integrator::TraceWavefront(std::span<const PixelSample> samples,
+                                const Camera::View_Info& view,
+                                const Point3& origin,
+                                Sampler& sampler,
+                                std::span<Color> out,
+                                std::span<FirstHit> first_hits) const {
+  // a path waiting to be shaded at its current vertex
+  struct ShadeItem {
+    const IMaterial* mat;
+    uint32_t path;
+    uint32_t hit;
+    BounceSamples u;
+  };
+
+  // queues are reused between waves, every stage refills them
+  thread_local PathStates paths;
+  thread_local std::vector<uint32_t> active, next;
+  thread_local std::vector<HitRecord> hits;
+  thread_local std::vector<ShadeItem> shade;
+  thread_local ShadowQueue shadow;
+
+  // the sampler is resumed at each path's own dimension before drawing, so
+  // every path sees the same numbers as when traced on its own
+  auto resume = [&](uint32_t p) {
+    const PixelSample& s = samples[p];
+    sampler.StartPixelSample(s.x, s.y, s.sample_index, paths.dim[p]);
+  };
+
+  // 1. camera rays
+  const size_t n = samples.size();
+  paths.Resize(n);
+  active.resize(n);
+  for (uint32_t p = 0; p < n; ++p) {
+    const PixelSample& s = samples[p];
+    paths.dim[p] = 0;
+    resume(p);
+    const Point2 u_pixel = sampler.Get2D();
+    const Point3 jittered = view.pixel00_loc +
+                            view.pixel_delta_u * s.x +
+                            view.pixel_delta_v * s.y +
+                            u_pixel.x() * view.pixel_delta_u +
+                            u_pixel.y() * view.pixel_delta_v;
+    paths.ray[p] = Ray(origin, jittered - origin);
+    paths.beta[p] = Color(1);
+    paths.L[p] = Color(0);
+    paths.dim[p] = 2;
+    paths.mis_pdf[p] = 0;
+    active[p] = p;
+  }
+
+  for (int depth = 0; depth < max_depth_ && !active.empty(); ++depth) {
+    // 2. closest hits
+    hits.resize(active.size());
+    for (size_t k = 0; k < active.size(); ++k)
+      hits[k] = scene_.Hit(paths.ray[active[k]], Interval<Float>::Positive());
+    // every path is still active at depth 0, with k == p
+    if (depth == 0 && !first_hits.empty())
+      for (uint32_t p = 0; p < n; ++p)
+        first_hits[p] = hits[p].hits ? FirstHit::At(paths.ray[p], hits[p])
+                                     : FirstHit();
+
+    // 3. emission, then shading grouped by material
+    shade.clear();
+    for (size_t k = 0; k < active.size(); ++k) {
+      const uint32_t p = active[k];
+      resume(p);
+      const BounceSamples u = BounceSamples::Draw(sampler);
+      paths.dim[p] += kBounceDimensions;
+
+      const HitRecord& rec = hits[k];
+      if (!rec.hits) {
+        paths.L[p] += paths.beta[p] * scene_.Background(paths.ray[p]);
+        continue;
+      }
+      paths.L[p] += paths.beta[p] * rec.primitive->Le(paths.ray[p]) *
+                    EmissionWeight(paths.ray[p], paths.mis_pdf[p], rec);
+      if (const IMaterial* mat = ResolveMaterial(rec, u.u_material))
+        shade.push_back({mat, p, static_cast<uint32_t>(k), u});
+    }
+    std::sort(shade.begin(), shade.end(),
+              [](const ShadeItem& a, const ShadeItem& b) {
+                return std::less<>()(a.mat, b.mat) ||
+                       (a.mat == b.mat && a.path < b.path);
+              });
+
+    next.clear();
+    shadow.Clear();
+    for (const ShadeItem& it : shade) {
+      const uint32_t p = it.path;
+      const HitRecord& rec = hits[it.hit];
+      const BSDF bsdf = it.mat->GetBSDF(rec);
+      const bool use_mis = UseMis(bsdf);
+      if (use_mis)
+        if (auto ls = SampleLight(paths.ray[p], rec, bsdf, it.u))
+          shadow.Push(p, ls->shadow, ls->tmax, paths.beta[p] * ls->L);
+
+      if (auto scatter =
+              SampleScatter(paths.ray[p], rec, bsdf, use_mis, depth, it.u)) {
+        paths.beta[p] *= scatter->throughput;
+        paths.ray[p] = Ray(rec.position, scatter->wo);
+        paths.mis_pdf[p] = scatter->mis_pdf;
+        next.push_back(p);
+      }
+    }
+
+    // 4. shadow rays
+    for (size_t k = 0; k < shadow.Size(); ++k)
+      if (!scene_.Occluded(shadow.ray[k], shadow.tmax[k]))
+        paths.L[shadow.path[k]] += shadow.L[k];
+
+    // keep the paths in index order, so neighbouring pixels stay together
+    std::sort(next.begin(), next.end());
+    active.swap(next);
+  }
+
+  std::copy_n(paths.L.begin(), n, out.begin());
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "util/util.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Wavefront path tracing
+ * ----------------------
+ * Instead of following one path to its end before starting the next, a wave
+ * of paths is advanced one bounce at a time, in stages that each loop over a
+ * queue:
+ *  1. generate the camera ray of every pixel sample,
+ *  2. find the closest hit of every live path,
+ *  3. shade: add emission, queue a shadow ray towards a light sample and
+ *     sample the BSDF for the next ray. Paths are sorted by material first so
+ *     that the same BSDF code runs back to back,
+ *  4. trace the queued shadow rays with any-hit queries and add the light of
+ *     the unoccluded ones.
+ * Path state is kept as a structure of arrays indexed by path, each stage
+ * only touches the arrays it needs.
+ */
+
+// One camera sample to trace.
+struct PixelSample {
+  int x, y, sample_index;
+};
+
+struct PathStates {
+  void Resize(size_t n) {
+    ray.resize(n);
+    beta.resize(n);
+    L.resize(n);
+    dim.resize(n);
+    mis_pdf.resize(n);
+  }
+
+  std::vector<Ray> ray;        // the ray the path continues with
+  std::vector<Color> beta;     // product of the throughputs so far
+  std::vector<Color> L;        // radiance gathered so far
+  std::vector<int> dim;        // next sampler dimension
+  std::vector<Float> mis_pdf;  // of the last BSDF sample, see Scatter
+};
+
+// Shadow rays of one bounce, with the light each adds to its path if it
+// reaches the light.
+struct ShadowQueue {
+  void Clear() {
+    path.clear();
+    ray.clear();
+    tmax.clear();
+    L.clear();
+  }
+  void Push(uint32_t path_index, const Ray& r, Float t, const Color& contrib) {
+    path.push_back(path_index);
+    ray.push_back(r);
+    tmax.push_back(t);
+    L.push_back(contrib);
+  }
+  size_t Size() const noexcept { return path.size(); }
+
+  std::vector<uint32_t> path;
+  std::vector<Ray> ray;
+  std::vector<Float> tmax;
+  std::vector<Color> L;
+};
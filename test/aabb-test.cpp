@@ -107,6 +107,26 @@ TEST_F(aabbTest, parallelRayNoHit) {
       << r.Origin() << ' ' << r.Direction();
 }
 
+TEST_F(aabbTest, traversalRay) {
+  Ray r(Point3(0.5, 2, 0.5), Vector3(0.5, -2, -0.0));
+  TraversalRay tr(r);
+  EXPECT_EQ(tr.inv_dir.x(), 2);
+  EXPECT_EQ(tr.inv_dir.y(), -0.5);
+  EXPECT_EQ(tr.sign[0], 0);
+  EXPECT_EQ(tr.sign[1], 1);
+  EXPECT_EQ(tr.sign[2], 1);  // -0 points the negative way
+
+  EXPECT_TRUE(unit.isHitIn(tr, Interval<Float>::Positive()));
+  EXPECT_FALSE(unit.isHitIn(tr, Interval<Float>(0, 0.4)));
+}
+
+TEST_F(aabbTest, surfaceAreaAndCentroid) {
+  EXPECT_NEAR(unit.SurfaceArea(), 24, kEps);
+  EXPECT_NEAR(b1.SurfaceArea(), 2 * (1 * 2 + 2 * 2 + 2 * 1), kEps);
+  EXPECT_EQ(b1.Centroid(), Point3(0, 0, 0));
+  EXPECT_EQ(AABB(Point3(1, 2, 3), Point3(3, 2, 7)).Centroid(), Point3(2, 2, 5));
+}
+
 TEST(aabbComparer, canSortAABBs) {
   AABB a(Point3(-1, 0, 0), Point3(5, 0, 0)),
       b(Point3(-2, 0, 0), Point3(4, 0, 0)), c(Point3(4, 0, 1), Point3(0, 0, 0));
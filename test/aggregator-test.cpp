@@ -3,6 +3,8 @@
 
 #include <aggregator.hpp>
 #include <bsdf.hpp>
+#include <shapes/3d/sphere.hpp>
+#include <util/parallel.hpp>
 #include <util/util.hpp>
 
 #include <algorithm>
@@ -105,6 +107,136 @@ TEST_F(AggregatorTest, hit) {
   }
 }
 
+class AggregatorClosestHitTest
+    : public ::testing::TestWithParam<std::tuple<SplitMethod, int, int>> {};
+
+TEST_P(AggregatorClosestHitTest, MatchesBruteForce) {
+  std::vector<std::shared_ptr<Primitive>> spheres;
+  for (int i = 0; i < 2000; ++i)
+    spheres.push_back(std::make_shared<Primitive>(
+        std::make_shared<Sphere>((Point3)Vector3::Random(-100, 100),
+                                 random_float(0.1, 5)),
+        nullptr, nullptr));
+
+  BVTOptions opt;
+  std::tie(opt.split_method, opt.max_leaf_size, opt.width) = GetParam();
+  BVT bvt(spheres, opt);
+  EXPECT_LE(bvt.NodeCount(), 2 * spheres.size() - 1);
+  if (opt.width == 4) {
+    EXPECT_LE(bvt.NodeCount(), spheres.size());
+  }
+
+  for (int i = 0; i < 2000; ++i) {
+    Ray r((Point3)Vector3::Random(-200, 200), Vector3::Random_Unit());
+    auto t = Interval<Float>::Positive();
+
+    HitRecord expected;
+    for (const auto& it : spheres) {
+      auto rec = it->Hit(r, t);
+      if (rec.hits && (!expected.hits || rec.time < expected.time))
+        expected = rec;
+    }
+
+    auto rec = bvt.Hit(r, t);
+    ASSERT_EQ(rec.hits, expected.hits);
+    EXPECT_EQ(bvt.AnyHit(r, t), expected.hits);
+    if (rec.hits) {
+      EXPECT_EQ(rec.primitive, expected.primitive);
+      EXPECT_DOUBLE_EQ(rec.time, expected.time);
+      // nothing lies in front of the closest hit
+      EXPECT_FALSE(
+          bvt.AnyHit(r, Interval<Float>(t.begin, expected.time - 1e-6)));
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BuildOptions,
+    AggregatorClosestHitTest,
+    testing::Combine(testing::Values(SplitMethod::SAH, SplitMethod::Median),
+                     testing::Values(1, 4, 16),
+                     testing::Values(2, 4)));
+
+TEST_F(AggregatorTest, SahCostBelowMedian) {
+  // a dense cluster plus a sparse tail, where median splits do poorly
+  std::vector<std::shared_ptr<Primitive>> primitives;
+  for (int i = 0; i < 1000; ++i) {
+    Point3 p = i < 900 ? (Point3)Vector3::Random(0, 10)
+                       : Point3(random_float(100, 10000), 0, 0);
+    primitives.push_back(std::make_shared<Primitive>(
+        std::make_shared<FakeShape>(AABB{p, p + Vector3(1, 1, 1)}, 1.0),
+        nullptr, nullptr));
+  }
+
+  BVTOptions median;
+  median.split_method = SplitMethod::Median;
+  BVT sah_tree(primitives), median_tree(primitives, median);
+
+  EXPECT_EQ(sah_tree.GetBbox(), median_tree.GetBbox());
+  EXPECT_LT(sah_tree.SahCost(), median_tree.SahCost());
+}
+
+TEST_F(AggregatorTest, LeafSize) {
+  std::vector<std::shared_ptr<Primitive>> primitives;
+  for (int i = 0; i < 1024; ++i) {
+    Point3 p = (Point3)Vector3::Random(0, 100);
+    primitives.push_back(std::make_shared<Primitive>(
+        std::make_shared<FakeShape>(AABB{p, p + Vector3(1, 1, 1)}, 1.0),
+        nullptr, nullptr));
+  }
+
+  BVTOptions opt;
+  opt.width = 2;
+  opt.max_leaf_size = 1;
+  EXPECT_EQ(BVT(primitives, opt).NodeCount(), 2 * primitives.size() - 1);
+  opt.split_method = SplitMethod::Median;
+  EXPECT_EQ(BVT(primitives, opt).NodeCount(), 2 * primitives.size() - 1);
+
+  // 1024 primitives split evenly into leaves of 4
+  opt.max_leaf_size = 4;
+  EXPECT_EQ(BVT(primitives, opt).NodeCount(), 2 * 256 - 1);
+
+  // heavily overlapping primitives are not worth splitting under the SAH
+  std::vector<std::shared_ptr<Primitive>> overlapping;
+  for (int i = 0; i < 1024; ++i) {
+    Point3 p = (Point3)Vector3::Random(0, 1);
+    overlapping.push_back(std::make_shared<Primitive>(
+        std::make_shared<FakeShape>(AABB{p, p + Vector3(10, 10, 10)}, 1.0),
+        nullptr, nullptr));
+  }
+  opt.split_method = SplitMethod::SAH;
+  EXPECT_LT(BVT(overlapping, opt).NodeCount(), overlapping.size());
+}
+
+TEST_F(AggregatorTest, ParallelBuildMatchesSerial) {
+  // large enough for the concurrent subtree builds and binning to kick in
+  std::vector<std::shared_ptr<Primitive>> primitives;
+  for (int i = 0; i < 100000; ++i) {
+    Point3 p = (Point3)Vector3::Random(0, 1000);
+    primitives.push_back(std::make_shared<Primitive>(
+        std::make_shared<FakeShape>(AABB{p, p + Vector3(1, 1, 1)}, 1.0),
+        nullptr, nullptr));
+  }
+
+  BVTOptions opt;
+  opt.width = 2;
+  const unsigned threads = NumThreads();
+  SetNumThreads(1);
+  BVT serial(primitives, opt);
+  // two threads leave a single concurrent subtree level below the root
+  for (unsigned n : {2u, 8u}) {
+    SCOPED_TRACE(n);
+    SetNumThreads(n);
+    BVT parallel(primitives, opt);
+    EXPECT_EQ(serial.GetBbox(), parallel.GetBbox());
+    EXPECT_EQ(serial.NodeCount(), parallel.NodeCount());
+    EXPECT_DOUBLE_EQ(serial.SahCost(), parallel.SahCost());
+    EXPECT_TRUE(std::ranges::equal(serial.GetPrimitives(),
+                                   parallel.GetPrimitives()));
+  }
+  SetNumThreads(threads);
+}
+
 TEST_F(AggregatorTest, SingleObject) {
   auto obj = std::make_shared<Primitive>(
       std::make_shared<FakeShape>(AABB{Point3(0, 0, 0), Point3(1, 1, 1)}, 1.0),
@@ -118,6 +250,21 @@ TEST_F(AggregatorTest, SingleObject) {
   ASSERT_TRUE(rec.hits);
   EXPECT_EQ(rec.primitive, obj.get());
   EXPECT_TRUE(aggregator->GetBbox().Contains(obj->GetBbox()));
+  EXPECT_DOUBLE_EQ(aggregator->SahCost(), BVTOptions().intersect_cost);
+}
+
+TEST_F(AggregatorTest, ConservativeBounds) {
+  // 0.1 and 0.3 are not representable as float, node bounds must still
+  // enclose rays grazing the exact double-precision box
+  auto obj = std::make_shared<Primitive>(
+      std::make_shared<FakeShape>(
+          AABB{Point3(0.1, 0.1, 0.1), Point3(0.3, 0.3, 0.3)}, 1.0),
+      nullptr, nullptr);
+  aggregator = std::make_unique<BVT>(std::vector{obj});
+
+  Ray r(Point3(0.1 + 1e-12, 0.3 - 1e-12, -1), Vector3(0, 0, 1));
+  EXPECT_TRUE(aggregator->Hit(r, Interval<Float>::Positive()).hits);
+  EXPECT_EQ(aggregator->GetBbox(), obj->GetBbox());
 }
 
 TEST_F(AggregatorTest, Empty) {
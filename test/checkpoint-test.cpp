@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <checkpoint.hpp>
+#include <material.hpp>
+#include <primitive.hpp>
+#include <shapes/3d/sphere.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+class CheckpointTest : public ::testing::Test {
+ protected:
+  CheckpointTest() {
+    auto red = std::make_shared<DiffuseMaterial>(Color(0.8, 0.1, 0.1));
+    auto blue = std::make_shared<DiffuseMaterial>(Color(0.1, 0.1, 0.8));
+    for (auto mat : {red, blue, red})
+      prims_.push_back(std::make_shared<Primitive>(
+          std::make_shared<Sphere>(Point3(0, 0, 0), 1), mat, nullptr));
+  }
+  ~CheckpointTest() override { std::filesystem::remove(path_); }
+
+  std::vector<std::shared_ptr<Primitive>> prims_;
+  std::filesystem::path path_ =
+      std::filesystem::temp_directory_path() / "prismshift-test.ckpt";
+};
+
+TEST_F(CheckpointTest, SceneIds) {
+  SceneIds ids(prims_);
+  EXPECT_EQ(ids.Id(prims_[2].get()), 3);
+  EXPECT_EQ(ids.Id(prims_[2]->GetMaterial().get()), 1);
+  EXPECT_EQ(ids.Id(prims_[1]->GetMaterial().get()), 2);
+  EXPECT_EQ(ids.Id(static_cast<const Primitive*>(nullptr)), 0);
+  EXPECT_EQ(ids.GetPrimitive(1), prims_[0].get());
+  EXPECT_EQ(ids.GetMaterial(0), nullptr);
+  EXPECT_THROW(ids.GetMaterial(3), std::runtime_error);
+}
+
+TEST_F(CheckpointTest, RoundTrip) {
+  SceneIds ids(prims_);
+  Checkpoint ck;
+  ck.width = 3;
+  ck.height = 2;
+  ck.sampler = SamplerType::Halton;
+  ck.sampler_spp = 16;
+  ck.seed = 42;
+  ck.spp = 12;
+  ck.noise_threshold = 0.05;
+  ck.aovs = true;
+  ck.pixels.resize(6);
+  for (int i = 0; i < 6; ++i) {
+    PixelState& px = ck.pixels[i];
+    px.sum = Color(i, 0.1 * i, 1e-3);
+    px.n = 12 - i;
+    px.mean = 0.5 * i;
+    px.m2 = 0.25;
+    px.converged = i % 2;
+    px.aov.primitive = prims_[i % 3].get();
+    px.aov.material = prims_[i % 3]->GetMaterial().get();
+    px.aov.albedo = Color(0.5, 0.25, i);
+    px.aov.normal = Vector3(0, i, 1);
+    px.aov.distance = 3.5 * i;
+    px.aov.hits = i;
+    px.aov.samples = 12 - i;
+  }
+  WriteCheckpoint(path_, ck, ids);
+
+  const Checkpoint read = ReadCheckpoint(path_, ids);
+  EXPECT_EQ(read.width, 3);
+  EXPECT_EQ(read.height, 2);
+  EXPECT_EQ(read.sampler, SamplerType::Halton);
+  EXPECT_EQ(read.sampler_spp, 16);
+  EXPECT_EQ(read.seed, 42);
+  EXPECT_EQ(read.spp, 12);
+  EXPECT_EQ(read.noise_threshold, 0.05);
+  EXPECT_TRUE(read.aovs);
+  ASSERT_EQ(read.pixels.size(), 6);
+  for (int i = 0; i < 6; ++i) {
+    const PixelState &a = ck.pixels[i], &b = read.pixels[i];
+    EXPECT_EQ(a.sum, b.sum);
+    EXPECT_EQ(a.n, b.n);
+    EXPECT_EQ(a.mean, b.mean);
+    EXPECT_EQ(a.m2, b.m2);
+    EXPECT_EQ(a.converged, b.converged);
+    EXPECT_EQ(a.aov.primitive, b.aov.primitive);
+    EXPECT_EQ(a.aov.material, b.aov.material);
+    EXPECT_EQ(a.aov.albedo, b.aov.albedo);
+    EXPECT_EQ(a.aov.normal, b.aov.normal);
+    EXPECT_EQ(a.aov.distance, b.aov.distance);
+    EXPECT_EQ(a.aov.hits, b.aov.hits);
+    EXPECT_EQ(a.aov.samples, b.aov.samples);
+  }
+}
+
+TEST_F(CheckpointTest, RejectsBadFiles) {
+  SceneIds ids(prims_);
+  EXPECT_THROW(ReadCheckpoint(path_, ids), std::runtime_error);
+
+  std::ofstream(path_) << "not a checkpoint at all";
+  EXPECT_THROW(ReadCheckpoint(path_, ids), std::runtime_error);
+
+  // truncated
+  Checkpoint ck;
+  ck.width = ck.height = 4;
+  ck.sampler_spp = 1;
+  ck.pixels.resize(16);
+  WriteCheckpoint(path_, ck, ids);
+  std::filesystem::resize_file(path_, std::filesystem::file_size(path_) - 1);
+  EXPECT_THROW(ReadCheckpoint(path_, ids), std::runtime_error);
+}
@@ -35,7 +35,7 @@ TEST(ConductorTest, SamplePerfectSpecular) {
   static constexpr auto N = 16;
   for (size_t i = 0; i < N; ++i) {
     Vector3 wi = rand_sphere_uniform();
-    auto sample = mirror.Sample_f(wi);
+    auto sample = mirror.Sample_f(wi, random_uniform_01(), rand_point2());
     ASSERT_TRUE(sample.has_value());
     EXPECT_NEAR(sample->pdf, 1.0, kEps);
 
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <denoiser.hpp>
+#include <util/random.hpp>
+
+#include <stdexcept>
+
+namespace {
+// Flat guides: white albedo, facing the camera at depth 5. Pixels with
+// x >= edge face another way and are farther away.
+AovFilm MakeGuides(int width, int height, int edge) {
+  AovFilm guides(width, height);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x) {
+      const bool far = x >= edge;
+      guides.SetPixel(
+          x, y,
+          AovPixel{.albedo = Color(1),
+                   .normal = far ? Vector3(1, 0, 0) : Vector3(0, 0, 1),
+                   .depth = far ? Float(20) : Float(5),
+                   .primitive_id = 1,
+                   .material_id = 1,
+                   .sample_count = 8});
+    }
+  return guides;
+}
+
+Float Variance(const Film& film, int x0, int x1) {
+  Float sum = 0, sum2 = 0;
+  int n = 0;
+  for (int y = 0; y < film.Height(); ++y)
+    for (int x = x0; x < x1; ++x, ++n) {
+      const Float v = film.GetPixel(x, y).r();
+      sum += v;
+      sum2 += v * v;
+    }
+  return sum2 / n - (sum / n) * (sum / n);
+}
+}  // namespace
+
+TEST(DenoiserTest, KeepsConstantImage) {
+  constexpr int width = 67, height = 9;
+  Film film(width, height);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+      film.SetPixel(x, y, Color(0.25, 0.5, 2));
+
+  const Film out = Denoise(film, MakeGuides(width, height, width));
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x) {
+      const Color c = out.GetPixel(x, y);
+      ASSERT_NEAR(c.r(), 0.25, 1e-5);
+      ASSERT_NEAR(c.g(), 0.5, 1e-5);
+      ASSERT_NEAR(c.b(), 2, 1e-5);
+    }
+}
+
+TEST(DenoiserTest, RemovesNoiseButKeepsEdges) {
+  constexpr int width = 96, height = 48, edge = 48;
+  Film film(width, height);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x) {
+      const Float base = x < edge ? 0.2 : 0.8;
+      const Float v = base * (0.5 + random_uniform_01());
+      film.SetPixel(x, y, Color(v, v, v));
+    }
+
+  const Film out = Denoise(film, MakeGuides(width, height, edge));
+  EXPECT_LT(Variance(out, 0, edge), 0.1 * Variance(film, 0, edge));
+  EXPECT_LT(Variance(out, edge, width), 0.1 * Variance(film, edge, width));
+  // nothing bleeds across the edge in the normals and depths
+  for (int y = 0; y < height; ++y) {
+    EXPECT_NEAR(out.GetPixel(edge - 1, y).r(), 0.2, 0.05);
+    EXPECT_NEAR(out.GetPixel(edge, y).r(), 0.8, 0.15);
+  }
+}
+
+TEST(DenoiserTest, RejectsMismatchedGuides) {
+  EXPECT_THROW(Denoise(Film(4, 4), AovFilm(4, 5)), std::runtime_error);
+}
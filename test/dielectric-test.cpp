@@ -95,7 +95,7 @@ TEST_F(DielectricTest, ReflectAndRefract) {
   int reflects = 0, refracts = 0;
   for (int i = 0; i < N; ++i) {
     const Vector3 wi = rand_sphere_uniform();
-    auto sample = glass.Sample_f(wi);
+    auto sample = glass.Sample_f(wi, random_uniform_01(), rand_point2());
     ASSERT_TRUE(sample.has_value());
 
     const Vector3 wo = sample->wo;
@@ -126,7 +126,7 @@ TEST_F(DielectricTest, PdfBsdfConsistency) {
   int N = 10000, valid = 0;
   for (int i = 0; i < N; ++i) {
     Vector3 wi = rand_sphere_uniform();
-    if (auto s = rough.Sample_f(wi)) {
+    if (auto s = rough.Sample_f(wi, random_uniform_01(), rand_point2())) {
       ++valid;
 
       Float ratio = s->f[0] * AbsCosTheta(s->wo) / s->pdf;  // use red channel
@@ -164,7 +164,7 @@ TEST_F(DielectricTest, EnergyConservation) {
     wi = wi.Normalized();
 
     for (int j = 0; j < M; ++j) {  // integrate over wo
-      if (auto samp = rough.Sample_f(wi)) {
+      if (auto samp = rough.Sample_f(wi, random_uniform_01(), rand_point2())) {
         Float cos_o = AbsCosTheta(samp->wo);
         if (SameHemisphere(wi, samp->wo))
           reflected += samp->f[0] * cos_o / samp->pdf;
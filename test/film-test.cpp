@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <film.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+std::string WriteAndRead(const Film& film, const std::string& name) {
+  auto path = std::filesystem::temp_directory_path() / ("prismshift-" + name);
+  film.Write(path);
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::filesystem::remove(path);
+  return ss.str();
+}
+}  // namespace
+
+TEST(FilmTest, FormatFromExtension) {
+  EXPECT_EQ(ImageFormatFromPath("a.exr"), ImageFormat::Exr);
+  EXPECT_EQ(ImageFormatFromPath("dir/a.pfm"), ImageFormat::Pfm);
+  EXPECT_EQ(ImageFormatFromPath("a.ppm"), ImageFormat::Ppm);
+  EXPECT_EQ(ImageFormatFromPath("a.png"), ImageFormat::Png);
+  EXPECT_THROW(ImageFormatFromPath("a.jpg"), std::runtime_error);
+  EXPECT_THROW(ImageFormatFromPath("a"), std::runtime_error);
+}
+
+TEST(FilmTest, PfmKeepsHdrValues) {
+  Film film(3, 2);
+  film.SetPixel(0, 0, Color(7.5, 0.25, 0));  // top left
+  film.SetPixel(2, 1, Color(1, 2, 3));       // bottom right
+
+  const std::string data = WriteAndRead(film, "film-test.pfm");
+  const std::string header = "PF\n3 2\n-1\n";
+  ASSERT_EQ(data.size(), header.size() + 3 * 2 * 3 * sizeof(float));
+  ASSERT_EQ(data.substr(0, header.size()), header);
+
+  float px[18];
+  std::memcpy(px, data.data() + header.size(), sizeof(px));
+  // rows are stored bottom to top
+  EXPECT_EQ(px[6], 1.f);
+  EXPECT_EQ(px[7], 2.f);
+  EXPECT_EQ(px[8], 3.f);
+  EXPECT_EQ(px[9], 7.5f);
+  EXPECT_EQ(px[10], 0.25f);
+}
+
+TEST(FilmTest, BinaryPpm) {
+  Film film(2, 1);
+  film.SetPixel(0, 0, Color(100, 0.5, 0));
+  film.SetPixel(1, 0, Color(1, 1, 1));
+
+  const std::string data = WriteAndRead(film, "film-test.ppm");
+  const std::string header = "P6\n2 1\n255\n";
+  ASSERT_EQ(data.size(), header.size() + 6);
+  ASSERT_EQ(data.substr(0, header.size()), header);
+  const std::vector<uint8_t> expected = Tonemap8(film);
+  EXPECT_EQ(data.substr(header.size()),
+            std::string(expected.begin(), expected.end()));
+}
+
+TEST(FilmTest, Tonemap8ClampsAndQuantizes) {
+  Film film(3, 1);
+  film.SetPixel(0, 0, Color(0, 0, 0));
+  film.SetPixel(1, 0, Color(1e6, 1, 0.999));
+  film.SetPixel(2, 0, Color(0.5, 0.5, 0.5));
+
+  const std::vector<uint8_t> out = Tonemap8(film);
+  ASSERT_EQ(out.size(), 9);
+  EXPECT_EQ(out[0], 0);
+  EXPECT_EQ(out[3], 255);
+  EXPECT_EQ(out[4], 255);
+  // 0.5^(1/2.2) * 256
+  EXPECT_EQ(out[6], 186);
+}
+
+TEST(FilmTest, AovPixels) {
+  AovFilm aovs(2, 2);
+  const AovPixel p{.albedo = Color(0.5, 0.25, 1),
+                   .normal = Vector3(0, -1, 0),
+                   .depth = 12.5,
+                   .primitive_id = 1u << 30,
+                   .material_id = 3,
+                   .sample_count = 64};
+  aovs.SetPixel(1, 0, p);
+
+  const AovPixel q = aovs.GetPixel(1, 0);
+  EXPECT_EQ(q.albedo, p.albedo);
+  EXPECT_EQ(q.normal, p.normal);
+  EXPECT_EQ(q.depth, p.depth);
+  EXPECT_EQ(q.primitive_id, p.primitive_id);
+  EXPECT_EQ(q.material_id, p.material_id);
+  EXPECT_EQ(q.sample_count, p.sample_count);
+  EXPECT_EQ(aovs.GetPixel(0, 1).sample_count, 0);
+}
@@ -103,7 +103,7 @@ TEST(TrowbridgeReitzDistribution, VisibleNormalPDF) {
     Float sum2 = 0.0;
 
     for (int i = 0; i < N; ++i) {
-      const Vector3 wm = dist.Sample_wm(up);
+      const Vector3 wm = dist.Sample_wm(up, rand_point2());
       const Float pdf = dist.PDF(up, wm);
 
       ASSERT_GT(pdf, 0.0) << "PDF should never be zero or negative.";
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <integrator.hpp>
+#include <light.hpp>
+#include <material.hpp>
+#include <primitive.hpp>
+#include <scene.hpp>
+#include <shapes/3d/sphere.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+class IntegratorTest : public ::testing::Test {
+ protected:
+  IntegratorTest() : scene_(MakePrimitives()) {
+    scene_.SetBackground([](Ray) { return Color(0.1, 0.1, 0.2); });
+  }
+
+  static std::vector<std::shared_ptr<Primitive>> MakePrimitives() {
+    auto diffuse = std::make_shared<DiffuseMaterial>(Color(0.7, 0.5, 0.3));
+    auto glass = std::make_shared<DielectricMaterial>(1.5, 0.0, 0.0);
+    auto metal =
+        std::make_shared<ConductorMaterial>(Color(0.9, 0.9, 0.8), 0.2, 0.2);
+    auto mix = std::make_shared<MixedMaterial>(metal, diffuse, 0.5);
+
+    std::vector<std::shared_ptr<Primitive>> prims;
+    auto add = [&](Point3 c, Float r, std::shared_ptr<IMaterial> mat,
+                   std::shared_ptr<ILight> light = nullptr) {
+      prims.push_back(std::make_shared<Primitive>(
+          std::make_shared<Sphere>(c, r), std::move(mat), std::move(light)));
+    };
+    add(Point3(0, -1000, 0), 999.5, diffuse);
+    add(Point3(0, 0, 0), 0.5, glass);
+    add(Point3(1.2, 0, 0), 0.5, mix);
+    add(Point3(0, 3, 1), 0.5, nullptr, std::make_shared<Light>(Color(8)));
+    return prims;
+  }
+
+  std::string Render(const RenderOptions& opt, const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / ("prismshift-" + name);
+    Integrator integrator(scene_, 16);
+    integrator.Render(camera_, path, opt);
+    std::ifstream in(path);
+    std::string content{std::istreambuf_iterator<char>(in), {}};
+    std::filesystem::remove(path);
+    return content;
+  }
+
+  Scene scene_;
+  Camera camera_{Point3(0, 0.5, 4), Point3(0, 0, 0), 24, 1.5, 40};
+};
+
+TEST_F(IntegratorTest, WavefrontMatchesPathTracing) {
+  RenderOptions opt;
+  opt.spp = 8;
+  opt.tile_size = 7;
+  const std::string expected = Render(opt, "path.ppm");
+
+  // the paths see the same random numbers and only the order radiance is
+  // summed in differs, not enough to change 8-bit pixels
+  opt.wavefront = true;
+  EXPECT_EQ(Render(opt, "wavefront.ppm"), expected);
+}
+
+TEST_F(IntegratorTest, FirstHit) {
+  Integrator integrator(scene_, 16);
+  auto sampler = CreateSampler(SamplerType::Independent, 1);
+  sampler->StartPixelSample(0, 0, 0);
+
+  // straight at the glass sphere, with a direction that is not unit length
+  FirstHit hit;
+  integrator.Li(Ray(Point3(0, 0, 4), Vector3(0, 0, -2)), *sampler, &hit);
+  ASSERT_NE(hit.primitive, nullptr);
+  EXPECT_NE(dynamic_cast<const DielectricMaterial*>(hit.material), nullptr);
+  EXPECT_NEAR(hit.distance, 3.5, 1e-6);
+  EXPECT_NEAR(hit.normal.z(), 1, 1e-6);
+  EXPECT_EQ(hit.albedo, Color(1));
+
+  integrator.Li(Ray(Point3(0, 0, 4), Vector3(0, 0, 1)), *sampler, &hit);
+  EXPECT_EQ(hit.primitive, nullptr);
+  EXPECT_EQ(hit.material, nullptr);
+}
+
+TEST_F(IntegratorTest, MisMatchesBsdfSampling) {
+  // Light sampling with MIS-weighted emission must converge to what BSDF
+  // sampling alone finds, down onto the floor below the light.
+  const Ray r(Point3(0, 0.5, 3), Vector3(0, -1, -1.6));
+  auto mean = [&](bool mis) {
+    Integrator integrator(scene_, 16, mis);
+    auto sampler = CreateSampler(SamplerType::Independent, 1);
+    constexpr int n = 1 << 17;
+    Float sum = 0;
+    for (int i = 0; i < n; ++i) {
+      sampler->StartPixelSample(0, 0, i);
+      sum += integrator.Li(r, *sampler).Luminance();
+    }
+    return sum / n;
+  };
+  const Float expected = mean(false);
+  EXPECT_NEAR(mean(true), expected, 0.03 * expected);
+}
+
+TEST_F(IntegratorTest, AovsNeedExr) {
+  RenderOptions opt;
+  opt.spp = 1;
+  opt.aovs = true;
+  EXPECT_THROW(Render(opt, "aovs.ppm"), std::runtime_error);
+}
+
+TEST_F(IntegratorTest, PassesDoNotChangeTheImage) {
+  RenderOptions opt;
+  opt.spp = 8;
+  opt.noise_threshold = 0.05;
+  opt.min_spp = 2;
+  const std::string expected = Render(opt, "single-pass.ppm");
+
+  // a snapshot between every pass of 3 samples
+  opt.pass_spp = 3;
+  opt.snapshot_interval = 1e-9;
+  EXPECT_EQ(Render(opt, "passes.ppm"), expected);
+}
+
+TEST_F(IntegratorTest, TimeLimit) {
+  RenderOptions opt;
+  opt.time_limit = 0.05;
+  opt.pass_spp = 1;
+  const std::string header = "P6\n36 24\n255\n";
+  EXPECT_EQ(Render(opt, "time-limit.ppm").substr(0, header.size()), header);
+}
+
+TEST_F(IntegratorTest, ResumeMatchesUninterrupted) {
+  const auto checkpoint =
+      std::filesystem::temp_directory_path() / "prismshift-resume.ckpt";
+  RenderOptions opt;
+  opt.sampler = SamplerType::Independent;
+  opt.noise_threshold = 0.05;
+  opt.min_spp = 2;
+  opt.denoise = true;  // AOVs go through the checkpoint too
+  opt.spp = 8;
+  const std::string expected = Render(opt, "uninterrupted.ppm");
+
+  opt.spp = 3;
+  opt.checkpoint = checkpoint.string();
+  Render(opt, "interrupted.ppm");
+  opt.spp = 8;
+  opt.checkpoint.clear();
+  opt.resume = checkpoint.string();
+  EXPECT_EQ(Render(opt, "resumed.ppm"), expected);
+
+  // another sampler draws different samples
+  opt.sampler = SamplerType::Sobol;
+  EXPECT_THROW(Render(opt, "resumed.ppm"), std::runtime_error);
+  std::filesystem::remove(checkpoint);
+}
+
+TEST_F(IntegratorTest, ResumeWithoutAdaptiveSampling) {
+  const auto checkpoint =
+      std::filesystem::temp_directory_path() / "prismshift-adaptive.ckpt";
+  RenderOptions opt;
+  opt.sampler = SamplerType::Independent;
+  opt.spp = 16;
+  const std::string expected = Render(opt, "uninterrupted.ppm");
+
+  // pixels that converged under the threshold still take every sample
+  opt.spp = 8;
+  opt.noise_threshold = 0.2;
+  opt.min_spp = 2;
+  opt.checkpoint = checkpoint.string();
+  Render(opt, "adaptive.ppm");
+  opt.spp = 16;
+  opt.noise_threshold = 0;
+  opt.checkpoint.clear();
+  opt.resume = checkpoint.string();
+  EXPECT_EQ(Render(opt, "resumed.ppm"), expected);
+  std::filesystem::remove(checkpoint);
+}
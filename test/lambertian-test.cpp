@@ -34,7 +34,7 @@ TEST(LambertianTest, SampleF_ProvidesSelfConsistentSample) {
   Lambertian lambert(c);
 
   Vector3 wi{0, -1, 0};  // normal incidence
-  auto sampleOpt = lambert.Sample_f(wi);
+  auto sampleOpt = lambert.Sample_f(wi, random_uniform_01(), rand_point2());
   ASSERT_TRUE(sampleOpt.has_value());
 
   const auto& s = *sampleOpt;
@@ -55,7 +55,7 @@ TEST(LambertianTest, SampleF_IsCosineWeighted) {
   std::vector<Float> cos_thetas(N, 0);
   for (size_t i = 0; i < N; ++i) {
     const auto wi = rand_wi();
-    auto sample = lambert.Sample_f(wi);
+    auto sample = lambert.Sample_f(wi, random_uniform_01(), rand_point2());
     ASSERT_TRUE(sample.has_value());
     EXPECT_NEAR(sample->wo.Length_squared(), 1, kEps);
     EXPECT_GE(sample->wo.Dot(n), 0);
@@ -96,7 +96,7 @@ TEST(LambertianTest, SampleConvergence) {
   Float Iu = 0, Icos = 0;
   for (size_t i = 0; i < N; ++i) {
     auto wi = rand_wi();
-    auto sample = lambert.Sample_f(wi);
+    auto sample = lambert.Sample_f(wi, random_uniform_01(), rand_point2());
     Icos += sample->wo.y() / sample->pdf;
 
     auto wo = rand_wi();
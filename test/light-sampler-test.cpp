@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <light.hpp>
+#include <light_sampler.hpp>
+#include <primitive.hpp>
+#include <shapes/2d/parallelogram.hpp>
+#include <shapes/3d/sphere.hpp>
+#include <util/sampling.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+TEST(AliasTableTest, SamplesInProportion) {
+  const std::vector<Float> weights = {1, 0, 6, 3};
+  AliasTable table(weights);
+  ASSERT_EQ(table.Size(), 4u);
+  EXPECT_DOUBLE_EQ(table.Pmf(0), 0.1);
+  EXPECT_DOUBLE_EQ(table.Pmf(1), 0);
+  EXPECT_DOUBLE_EQ(table.Pmf(2), 0.6);
+
+  // evenly spaced u hit every index exactly as often as its pmf says
+  constexpr int n = 10000;
+  std::vector<int> count(weights.size());
+  for (int i = 0; i < n; ++i)
+    ++count[table.Sample((i + 0.5) / n)];
+  EXPECT_EQ(count[1], 0);
+  for (size_t i = 0; i < weights.size(); ++i)
+    EXPECT_NEAR(count[i], n * table.Pmf(i), 2);
+}
+
+TEST(AliasTableTest, ZeroWeightsAreUniform) {
+  const std::vector<Float> weights = {0, 0};
+  AliasTable table(weights);
+  EXPECT_DOUBLE_EQ(table.Pmf(1), 0.5);
+  EXPECT_EQ(table.Sample(0.25), 0u);
+  EXPECT_EQ(table.Sample(0.75), 1u);
+}
+
+TEST(LightSamplerTest, PowerFollowsRadianceAndArea) {
+  auto make = [](Float radius, Float radiance) {
+    return std::make_shared<Primitive>(
+        std::make_shared<Sphere>(Point3(0, 0, 0), radius), nullptr,
+        std::make_shared<Light>(Color(radiance)));
+  };
+  // the second light is four times larger and twice as bright
+  const std::vector<std::shared_ptr<Primitive>> lights = {make(1, 1),
+                                                          make(2, 2)};
+  const Point3 ref(0, 5, 0);
+
+  auto power = CreateLightSampler(LightSamplerType::Power, lights);
+  EXPECT_NEAR(power->Pmf(ref, 0), 1.0 / 9, 1e-9);
+  EXPECT_NEAR(power->Pmf(ref, 1), 8.0 / 9, 1e-9);
+  EXPECT_EQ(power->Sample(ref, 0.5)->index, 1u);
+
+  auto uniform = CreateLightSampler(LightSamplerType::Uniform, lights);
+  EXPECT_DOUBLE_EQ(uniform->Pmf(ref, 1), 0.5);
+  EXPECT_EQ(uniform->Sample(ref, 0.25)->index, 0u);
+
+  EXPECT_FALSE(
+      CreateLightSampler(LightSamplerType::Power, {})->Sample(ref, 0));
+  EXPECT_THROW(ParseLightSamplerType("tree"), std::runtime_error);
+}
+
+TEST(LightSamplerTest, BvhFavoursNearbyLights) {
+  // a row of small quads facing down, one of them dark, and a sphere
+  std::vector<std::shared_ptr<Primitive>> lights;
+  for (int i = 0; i < 40; ++i) {
+    const Point3 o(i, 2, 0);
+    lights.push_back(std::make_shared<Primitive>(
+        std::make_shared<Parallelogram>(o, o + Vector3(0.5, 0, 0),
+                                        o + Vector3(0, 0, 0.5)),
+        nullptr, std::make_shared<Light>(Color(i == 7 ? 0 : 1))));
+  }
+  lights.push_back(std::make_shared<Primitive>(
+      std::make_shared<Sphere>(Point3(20, 5, 0), 1), nullptr,
+      std::make_shared<Light>(Color(2))));
+  BvhLightSampler sampler(lights);
+
+  for (const Point3 ref : {Point3(3, 0, 0), Point3(30.5, 1, 0.2),
+                           Point3(-10, -4, 3), Point3(20, 5, 0)}) {
+    Float sum = 0;
+    for (size_t i = 0; i < lights.size(); ++i)
+      sum += sampler.Pmf(ref, i);
+    EXPECT_NEAR(sum, 1, 1e-9);
+    EXPECT_EQ(sampler.Pmf(ref, 7), 0);
+
+    for (int k = 0; k < 64; ++k) {
+      const auto sampled = sampler.Sample(ref, (k + 0.5) / 64);
+      ASSERT_TRUE(sampled);
+      EXPECT_NE(sampled->index, 7u);
+      EXPECT_NEAR(sampled->pmf, sampler.Pmf(ref, sampled->index), 1e-12);
+    }
+  }
+
+  // the quad right above is far more likely than one at the other end
+  const Point3 below(3.25, 0, 0.25);
+  EXPECT_GT(sampler.Pmf(below, 3), 20 * sampler.Pmf(below, 39));
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <mesh_loader.hpp>
+#include <util/parallel.hpp>
+#include <util/util.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+class MeshLoaderTest : public ::testing::Test {
+ protected:
+  std::filesystem::path Write(const std::string& name,
+                              const std::string& content) {
+    auto path = std::filesystem::temp_directory_path() / ("prismshift-" + name);
+    std::ofstream(path, std::ios::binary) << content;
+    files_.push_back(path);
+    return path;
+  }
+
+  void TearDown() override {
+    for (const auto& it : files_)
+      std::filesystem::remove(it);
+  }
+
+  template <typename T>
+  static void Put(std::string& out, T value, bool big_endian = false) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (big_endian != (std::endian::native == std::endian::big))
+      std::reverse(bytes, bytes + sizeof(T));
+    out.append(bytes, sizeof(T));
+  }
+
+  // a unit quad and a triangle, stored as one 4-gon and one 3-gon
+  std::string QuadPly(bool big_endian) {
+    std::string ply =
+        std::string("ply\nformat ") +
+        (big_endian ? "binary_big_endian" : "binary_little_endian") +
+        " 1.0\n"
+        "comment test\n"
+        "element vertex 5\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "property double u\nproperty double v\n"
+        "element face 2\n"
+        "property uchar flags\n"
+        "property list uchar int vertex_indices\n"
+        "element edge 1\n"
+        "property list uchar int vertex_pair\n"
+        "end_header\n";
+    const float pos[5][3] = {
+        {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 2, 2}};
+    for (int i = 0; i < 5; ++i) {
+      for (float f : pos[i])
+        Put(ply, f, big_endian);
+      Put(ply, static_cast<double>(pos[i][0]), big_endian);
+      Put(ply, static_cast<double>(pos[i][1]), big_endian);
+    }
+    Put<uint8_t>(ply, 7);
+    Put<uint8_t>(ply, 4);
+    for (int32_t i : {0, 1, 2, 3})
+      Put(ply, i, big_endian);
+    Put<uint8_t>(ply, 0);
+    Put<uint8_t>(ply, 3);
+    for (int32_t i : {1, 4, 2})
+      Put(ply, i, big_endian);
+    Put<uint8_t>(ply, 2);
+    Put<int32_t>(ply, 0, big_endian);
+    Put<int32_t>(ply, 1, big_endian);
+    return ply;
+  }
+
+ private:
+  std::vector<std::filesystem::path> files_;
+};
+
+TEST_F(MeshLoaderTest, Ply) {
+  for (bool big_endian : {false, true}) {
+    auto mesh = LoadMesh(Write("quad.ply", QuadPly(big_endian)));
+    ASSERT_EQ(mesh->TriangleCount(), 3);
+    EXPECT_EQ(mesh->Indices(),
+              (std::vector<uint32_t>{0, 1, 2, 0, 2, 3, 1, 4, 2}));
+    EXPECT_EQ(mesh->Positions()[2], Point3(1, 1, 0));
+    EXPECT_EQ(mesh->Positions()[4], Point3(2, 2, 2));
+    ASSERT_EQ(mesh->Uvs().size(), 5);
+    EXPECT_EQ(mesh->Uvs()[3], Point2(0, 1));
+    EXPECT_TRUE(mesh->Normals().empty());
+  }
+}
+
+TEST_F(MeshLoaderTest, PlyErrors) {
+  EXPECT_THROW(LoadMesh(Write("ascii.ply",
+                              "ply\nformat ascii 1.0\nelement vertex 0\n"
+                              "end_header\n")),
+               std::runtime_error);
+  std::string truncated = QuadPly(false);
+  truncated.resize(truncated.size() - 20);
+  EXPECT_THROW(LoadMesh(Write("truncated.ply", truncated)),
+               std::runtime_error);
+  EXPECT_THROW(LoadMesh("/nonexistent/mesh.ply"), std::runtime_error);
+
+  // counts far beyond the data must not be used to size anything
+  for (const char* element : {"element vertex", "element face"}) {
+    std::string huge = QuadPly(false);
+    const size_t at = huge.find(element) + std::strlen(element) + 1;
+    huge.replace(at, 1, "4611686018427387904");
+    EXPECT_THROW(LoadMesh(Write("huge.ply", huge)), std::runtime_error);
+  }
+}
+
+TEST_F(MeshLoaderTest, Obj) {
+  auto mesh = LoadMesh(Write("quad.obj",
+                             "# comment\n"
+                             "o quad\n"
+                             "v 0 0 0\nv 1 0 0\r\nv 1 1 0\nv 0 1 0\n"
+                             "vn 0 0 1\n"
+                             "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                             "usemtl none\n"
+                             "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+                             "f -4/-4/-1 -2/-2/-1 -1/-1/-1\n"));
+  // the quad is fanned into two triangles, both faces share corners
+  ASSERT_EQ(mesh->TriangleCount(), 3);
+  EXPECT_EQ(mesh->Positions().size(), 4);
+  ASSERT_EQ(mesh->Normals().size(), 4);
+  EXPECT_EQ(mesh->Normals()[0], Normal(0, 0, 1));
+  const auto& idx = mesh->Indices();
+  EXPECT_EQ(mesh->Positions()[idx[4]], Point3(1, 1, 0));
+  EXPECT_EQ(mesh->Uvs()[idx[4]], Point2(1, 1));
+  EXPECT_EQ(mesh->Positions()[idx[7]], Point3(1, 1, 0));
+  EXPECT_EQ(mesh->Positions()[idx[8]], Point3(0, 1, 0));
+
+  EXPECT_THROW(LoadMesh(Write("bad.obj", "v 0 0 0\nf 1 2 3\n")),
+               std::runtime_error);
+  EXPECT_THROW(LoadMesh(Write("mesh.stl", "")), std::runtime_error);
+}
+
+TEST_F(MeshLoaderTest, ObjChunksMatchSerial) {
+  // a grid large enough to be split into several chunks
+  constexpr int n = 120;
+  std::ostringstream oss;
+  for (int y = 0; y <= n; ++y)
+    for (int x = 0; x <= n; ++x)
+      oss << "v " << x << ' ' << y << " 0.5\n";
+  for (int y = 0; y < n; ++y)
+    for (int x = 0; x < n; ++x) {
+      const int i = y * (n + 1) + x + 1;
+      if ((x + y) % 2)
+        oss << "f " << i << ' ' << i + 1 << ' ' << i + n + 2 << ' '
+            << i + n + 1 << '\n';
+      else  // relative indices
+        oss << "f -1 -2 -3\nv " << x << ' ' << y << " 1\n";
+    }
+  auto path = Write("grid.obj", oss.str());
+
+  const unsigned threads = NumThreads();
+  SetNumThreads(1);
+  auto serial = LoadObj(path);
+  SetNumThreads(4);
+  auto parallel = LoadObj(path);
+  SetNumThreads(threads);
+
+  EXPECT_EQ(serial->TriangleCount(), n * n / 2 * 3);
+  EXPECT_EQ(serial->Indices(), parallel->Indices());
+  EXPECT_EQ(serial->Positions(), parallel->Positions());
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <util/parallel.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ParallelForTest, VisitsEveryIndexOnce) {
+  std::vector<std::atomic<int>> visits(10007);
+  ParallelFor(
+      0, visits.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          ++visits[i];
+      },
+      /*grain=*/100);
+
+  for (const auto& it : visits)
+    EXPECT_EQ(it.load(), 1);
+}
+
+TEST(ParallelForTest, EmptyRange) {
+  bool called = false;
+  ParallelFor(5, 5, [&](size_t, size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelForTest, PropagatesException) {
+  const unsigned threads = NumThreads();
+  SetNumThreads(4);
+  EXPECT_THROW(ParallelFor(
+                   0, 1000,
+                   [](size_t begin, size_t) {
+                     if (begin > 0)
+                       throw std::runtime_error("worker failed");
+                   },
+                   /*grain=*/1),
+               std::runtime_error);
+  SetNumThreads(threads);
+}
@@ -0,0 +1,21 @@
+#include <gtest/gtest.h>
+
+#include <util/random.hpp>
+
+TEST(RandomTest, AdvanceMatchesStepping) {
+  PCG32 a(7, 42), b(7, 42);
+  for (int i = 0; i < 1000; ++i)
+    a.Uniform32();
+  b.Advance(1000);
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(a.Uniform32(), b.Uniform32());
+}
+
+TEST(RandomTest, Ranges) {
+  for (int i = 0; i < 10000; ++i) {
+    const Float u = random_uniform_01();
+    EXPECT_TRUE(0 <= u && u < 1);
+    const int k = random_int(-2, 3);
+    EXPECT_TRUE(-2 <= k && k <= 3);
+  }
+}
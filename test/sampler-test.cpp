@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <sampler.hpp>
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace {
+constexpr SamplerType kAllTypes[] = {
+    SamplerType::Independent, SamplerType::Stratified, SamplerType::Halton,
+    SamplerType::Sobol};
+}  // namespace
+
+TEST(SamplerTest, ReproducibleAndInRange) {
+  for (SamplerType type : kAllTypes) {
+    auto sampler = CreateSampler(type, 16);
+    auto clone = sampler->Clone();
+
+    std::vector<Float> first;
+    for (int i = 0; i < 16; ++i) {
+      sampler->StartPixelSample(3, 7, i);
+      for (int d = 0; d < 20; ++d) {
+        const Float u = sampler->Get1D();
+        const Point2 p = sampler->Get2D();
+        for (Float it : {u, p.x(), p.y()}) {
+          ASSERT_GE(it, 0);
+          ASSERT_LT(it, 1);
+          first.push_back(it);
+        }
+      }
+    }
+
+    // rendering the samples in another order or on another clone does not
+    // change them
+    for (int i = 15; i >= 0; --i) {
+      clone->StartPixelSample(3, 7, i);
+      for (int d = 0; d < 20; ++d) {
+        EXPECT_EQ(clone->Get1D(), first[i * 60 + d * 3]);
+        const Point2 p = clone->Get2D();
+        EXPECT_EQ(p.x(), first[i * 60 + d * 3 + 1]);
+        EXPECT_EQ(p.y(), first[i * 60 + d * 3 + 2]);
+      }
+    }
+  }
+}
+
+TEST(SamplerTest, Stratification) {
+  // with a power-of-two spp every 1D dimension puts one sample in each of
+  // spp strata (for Halton only the base 2 one), and the 2D dimensions of the
+  // stratified and Sobol samplers one in each cell of a 4 x 4 grid
+  constexpr int spp = 16;
+  for (SamplerType type : {SamplerType::Stratified, SamplerType::Halton,
+                           SamplerType::Sobol}) {
+    auto sampler = CreateSampler(type, spp);
+    const int dims = type == SamplerType::Halton ? 1 : 8;
+    for (int dim = 0; dim < dims; ++dim) {
+      std::set<int> strata;
+      for (int i = 0; i < spp; ++i) {
+        sampler->StartPixelSample(11, 5, i, dim);
+        strata.insert(static_cast<int>(sampler->Get1D() * spp));
+      }
+      EXPECT_EQ(strata.size(), spp) << static_cast<int>(type) << ' ' << dim;
+    }
+    if (type == SamplerType::Halton)
+      continue;
+
+    std::set<int> cells;
+    for (int i = 0; i < spp; ++i) {
+      sampler->StartPixelSample(11, 5, i, 4);
+      const Point2 p = sampler->Get2D();
+      cells.insert(static_cast<int>(p.x() * 4) * 4 +
+                   static_cast<int>(p.y() * 4));
+    }
+    EXPECT_EQ(cells.size(), spp) << static_cast<int>(type);
+  }
+}
+
+TEST(SamplerTest, LowDiscrepancyConvergesFaster) {
+  // integrate u * v over the unit square, exact value 1/4
+  auto error = [](SamplerType type) {
+    constexpr int spp = 64, pixels = 200;
+    auto sampler = CreateSampler(type, spp);
+    Float total = 0;
+    for (int px = 0; px < pixels; ++px) {
+      Float sum = 0;
+      for (int i = 0; i < spp; ++i) {
+        sampler->StartPixelSample(px, 0, i, 2);
+        const Point2 p = sampler->Get2D();
+        sum += p.x() * p.y();
+      }
+      total += std::abs(sum / spp - 0.25);
+    }
+    return total / pixels;
+  };
+
+  const Float independent = error(SamplerType::Independent);
+  EXPECT_LT(error(SamplerType::Stratified), independent);
+  EXPECT_LT(error(SamplerType::Halton), independent);
+  EXPECT_LT(error(SamplerType::Sobol), 0.5 * independent);
+}
+
+TEST(SamplerTest, PermutationElement) {
+  for (uint32_t n : {1u, 2u, 7u, 64u, 1000u}) {
+    std::set<uint32_t> seen;
+    for (uint32_t i = 0; i < n; ++i)
+      seen.insert(PermutationElement(i, n, 0x1234567));
+    EXPECT_EQ(seen.size(), n);
+    EXPECT_LT(*seen.rbegin(), n);
+  }
+}
+
+TEST(SamplerTest, ParseSamplerType) {
+  EXPECT_EQ(ParseSamplerType("sobol"), SamplerType::Sobol);
+  EXPECT_THROW(ParseSamplerType("random"), std::runtime_error);
+  EXPECT_THROW(CreateSampler(SamplerType::Halton, 0), std::runtime_error);
+}
@@ -90,6 +90,7 @@ TYPED_TEST(PlaneTest, RayHit) {
     HitRecord rec = this->shape->Hit(r, Interval<Float>::Positive());
     EXPECT_TRUE(rec.hits) << this->o << ' ' << this->a << ' ' << this->b << '\n'
                           << r;
+    EXPECT_TRUE(this->shape->Intersects(r, Interval<Float>::Positive()));
     EXPECT_NEAR(rec.time, time, this->EPS);
     EXPECT_EQ(rec.position, on_plane);
     Normal n = rec.normal;
@@ -115,6 +116,8 @@ TYPED_TEST(PlaneTest, HitOutsideInterval) {
 
     auto rec = this->shape->Hit(r, Interval<Float>(0, time - this->EPS));
     ASSERT_FALSE(rec.hits);
+    EXPECT_FALSE(
+        this->shape->Intersects(r, Interval<Float>(0, time - this->EPS)));
   }
 }
 
@@ -129,6 +132,7 @@ TYPED_TEST(PlaneTest, NoHit) {
 
     auto rec = this->shape->Hit(r, Interval<Float>::Positive());
     EXPECT_FALSE(rec.hits);
+    EXPECT_FALSE(this->shape->Intersects(r, Interval<Float>::Positive()));
   }
 }
 
@@ -150,3 +154,50 @@ TEST(TriangleTest, regression) {
   EXPECT_NO_THROW(tri = std::make_shared<Triangle>(o, a, b));
   EXPECT_NE(tri, nullptr);
 }
+
+TEST(ParallelogramTest, SolidAngleSampling) {
+  const Point3 o(1, 2, 3);
+  const Vector3 ex(2, 0, 0), ey(0, 1, -1);
+  const Parallelogram rect(o, o + ex, o + ey);
+  const Point3 ref(0.5, 3, 3.5);
+
+  // the solid angle by area sampling: the integral of cos / d^2 dA
+  Float solid_angle = 0;
+  constexpr int n = 1 << 16;
+  for (int i = 0; i < n; ++i) {
+    const ShapeSample s = rect.Sample(rand_point2());
+    const Vector3 d = s.pos - ref;
+    solid_angle += std::abs(Vector3::Dot(s.normal, d)) /
+                   (d.Length_squared() * d.Length() * s.pdf) / n;
+  }
+
+  // Uniform in solid angle: the samples are on the rectangle and the
+  // fraction landing in its first half is the solid angle of that half.
+  const Parallelogram half(o, o + 0.5 * ex, o + ey);
+  int in_half = 0;
+  for (int i = 0; i < n; ++i) {
+    const ShapeSample s = rect.Sample(ref, rand_point2());
+    EXPECT_NEAR(1 / s.pdf, solid_angle, 0.01 * solid_angle);
+    const Vector3 local = s.pos - o;
+    const Float a = Vector3::Dot(local, ex) / ex.Length_squared();
+    const Float b = Vector3::Dot(local, ey) / ey.Length_squared();
+    ASSERT_TRUE(-1e-9 < a && a < 1 + 1e-9 && -1e-9 < b && b < 1 + 1e-9);
+    in_half += a < 0.5;
+
+    const HitRecord rec =
+        rect.Hit(Ray(ref, s.pos - ref), Interval<Float>::Positive());
+    ASSERT_TRUE(rec.hits);
+    EXPECT_DOUBLE_EQ(rect.Pdf(ref, rec), s.pdf);
+  }
+  const ShapeSample h = half.Sample(ref, Point2(0.5, 0.5));
+  EXPECT_NEAR(Float(in_half) / n, 1 / (h.pdf * solid_angle), 0.01);
+
+  // parallelograms that are not rectangles fall back to area sampling
+  const Parallelogram skewed(o, o + ex, o + ex + ey);
+  const ShapeSample s = skewed.Sample(ref, Point2(0.3, 0.6));
+  const Vector3 d = s.pos - ref;
+  EXPECT_NEAR(s.pdf,
+              d.Length_squared() * d.Length() /
+                  (std::abs(Vector3::Dot(s.normal, d)) * skewed.Area()),
+              1e-9);
+}
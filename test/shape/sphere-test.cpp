@@ -99,6 +99,7 @@ TEST_F(SphereTest, RayHits) {
 
       rec = sphere->Hit(r, Interval<Float>::Positive());
       EXPECT_TRUE(rec.hits) << ray_point << ' ' << on_sphere;
+      EXPECT_TRUE(sphere->Intersects(r, Interval<Float>::Positive()));
       EXPECT_NEAR(rec.time, time, EPS);
 
       // outside
@@ -111,6 +112,7 @@ TEST_F(SphereTest, RayHits) {
 
       rec = sphere->Hit(r, Interval<Float>::Positive());
       EXPECT_TRUE(rec.hits) << ray_point << ' ' << on_sphere;
+      EXPECT_TRUE(sphere->Intersects(r, Interval<Float>::Positive()));
       EXPECT_NEAR(rec.time, time, EPS);
     }
   }
@@ -133,6 +135,7 @@ TEST_F(SphereTest, HitOutsideTimeInterval) {
 
       rec = sphere->Hit(r, Interval<Float>(0, time - EPS));
       EXPECT_FALSE(rec.hits) << ray_point << ' ' << on_sphere;
+      EXPECT_FALSE(sphere->Intersects(r, Interval<Float>(0, time - EPS)));
 
       // outside
       on_sphere = Point3(rand_sphere_uniform() * sphere->r());
@@ -144,6 +147,7 @@ TEST_F(SphereTest, HitOutsideTimeInterval) {
 
       rec = sphere->Hit(r, Interval<Float>(0, time - EPS));
       EXPECT_FALSE(rec.hits) << ray_point << ' ' << on_sphere;
+      EXPECT_FALSE(sphere->Intersects(r, Interval<Float>(0, time - EPS)));
     }
   }
 }
@@ -159,6 +163,32 @@ TEST_F(SphereTest, Nohit) {
       Ray r = Ray(p - vp, vp);
       auto rec = sphere->Hit(r, Interval<Float>::Universe());
       EXPECT_FALSE(rec.hits) << r;
+      EXPECT_FALSE(sphere->Intersects(r, Interval<Float>::Universe()));
     }
   }
 }
+
+TEST_F(SphereTest, SolidAngleSampling) {
+  for (Float dist : {1.5, 4.0, 100.0}) {
+    const Point3 ref = o + dist * r * rand_sphere_uniform();
+    const Float sin2 = 1 / (dist * dist);
+    const Float expected = 1 / (2 * pi * (1 - std::sqrt(1 - sin2)));
+    for (int i = 0; i < N; ++i) {
+      const ShapeSample s = rand_sphere.Sample(ref, rand_point2());
+      // on the side facing ref, with the pdf of a uniform cone
+      EXPECT_NEAR((s.pos - o).Length(), r, EPS);
+      EXPECT_GT(Vector3::Dot(s.normal, ref - s.pos), -EPS);
+      EXPECT_NEAR(s.pdf / expected, 1, dist > 10 ? 1e-3 : EPS);
+
+      const HitRecord rec = rand_sphere.Hit(Ray(ref, s.pos - ref),
+                                            Interval<Float>::Positive());
+      ASSERT_TRUE(rec.hits);
+      EXPECT_NEAR(rec.time, 1, EPS);
+      EXPECT_DOUBLE_EQ(rand_sphere.Pdf(ref, rec), s.pdf);
+    }
+  }
+
+  // from inside, the whole sphere by area
+  const ShapeSample s = rand_sphere.Sample(o, rand_point2());
+  EXPECT_NEAR(s.pdf, r * r / rand_sphere.Area(), EPS);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <primitive.hpp>
+#include <shapes/2d/triangle.hpp>
+#include <shapes/2d/triangle_mesh.hpp>
+#include <util/util.hpp>
+
+#include <memory>
+
+class TriangleMeshTest : public ::testing::Test {
+ protected:
+  // unit square in the xz plane, split along its diagonal
+  std::shared_ptr<TriangleMesh> square = std::make_shared<TriangleMesh>(
+      std::vector<Point3>{Point3(0, 0, 0), Point3(1, 0, 0), Point3(1, 0, 1),
+                          Point3(0, 0, 1)},
+      std::vector<uint32_t>{0, 1, 2, 0, 2, 3});
+  MeshTriangle lower{square, 0}, upper{square, 1};
+};
+
+TEST_F(TriangleMeshTest, InvalidBuffers) {
+  EXPECT_THROW(TriangleMesh({Point3(0, 0, 0)}, {0, 0}), std::runtime_error);
+  EXPECT_THROW(TriangleMesh({Point3(0, 0, 0)}, {0, 0, 1}), std::runtime_error);
+  EXPECT_THROW(
+      TriangleMesh({Point3(0, 0, 0)}, {0, 0, 0}, {}, {Point2(0, 0), Point2(1, 1)}),
+      std::runtime_error);
+}
+
+TEST_F(TriangleMeshTest, BboxAndArea) {
+  EXPECT_TRUE(lower.GetBbox().Contains(Point3(1, 0, 1)));
+  EXPECT_TRUE(upper.GetBbox().Contains(Point3(0, 0, 1)));
+  EXPECT_DOUBLE_EQ(lower.Area(), 0.5);
+  EXPECT_DOUBLE_EQ(upper.Area(), 0.5);
+}
+
+TEST_F(TriangleMeshTest, MatchesTriangle) {
+  Triangle reference(Point3(0, 0, 0), Point3(1, 0, 0), Point3(1, 0, 1));
+  for (int i = 0; i < 100; ++i) {
+    Point3 target(random_float(-0.5, 1.5), 0, random_float(-0.5, 1.5));
+    Point3 origin = (Point3)Vector3::Random(-5, 5);
+    Ray r(origin, (target - origin).Normalized());
+
+    auto expected = reference.Hit(r, Interval<Float>::Positive());
+    auto rec = lower.Hit(r, Interval<Float>::Positive());
+    ASSERT_EQ(rec.hits, expected.hits) << r;
+    EXPECT_EQ(lower.Intersects(r, Interval<Float>::Positive()), rec.hits);
+    if (rec.hits) {
+      EXPECT_NEAR(rec.time, expected.time, 1e-9);
+      EXPECT_EQ(rec.position, expected.position);
+      EXPECT_NEAR(std::abs(rec.normal.Dot(expected.normal)), 1, 1e-9);
+    }
+  }
+}
+
+TEST_F(TriangleMeshTest, Watertight) {
+  // rays through the shared diagonal must hit at least one of the triangles
+  for (int i = 0; i < 1000; ++i) {
+    const Float s = random_uniform_01();
+    Point3 target(s, 0, s);
+    Point3 origin = (Point3)Vector3::Random(-5, 5);
+    Ray r(origin, target - origin);
+
+    EXPECT_TRUE(lower.Intersects(r, Interval<Float>::Universe()) ||
+                upper.Intersects(r, Interval<Float>::Universe()))
+        << r;
+  }
+}
+
+TEST_F(TriangleMeshTest, InterpolatedAttributes) {
+  auto mesh = std::make_shared<TriangleMesh>(
+      std::vector<Point3>{Point3(0, 0, 0), Point3(1, 0, 0), Point3(0, 0, 1)},
+      std::vector<uint32_t>{0, 1, 2},
+      std::vector<Normal>{Normal(0, 1, 0), Normal(1, 0, 0), Normal(0, 0, 1)},
+      std::vector<Point2>{Point2(0, 0), Point2(2, 0), Point2(0, 4)});
+  MeshTriangle tri(mesh, 0);
+
+  Ray r(Point3(0.5, 1, 0.25), Vector3(0, -1, 0));
+  auto rec = tri.Hit(r, Interval<Float>::Positive());
+  ASSERT_TRUE(rec.hits);
+  EXPECT_DOUBLE_EQ(rec.time, 1);
+  EXPECT_NEAR(rec.uv.x(), 1, 1e-12);
+  EXPECT_NEAR(rec.uv.y(), 1, 1e-12);
+  EXPECT_EQ(rec.normal, Normal(0.5, 0.25, 0.25));
+}
+
+TEST_F(TriangleMeshTest, CreatePrimitives) {
+  auto prims = TriangleMesh::CreatePrimitives(square, nullptr, nullptr);
+  ASSERT_EQ(prims.size(), 2);
+  EXPECT_EQ(prims[1]->GetShape()->Area(), 0.5);
+}
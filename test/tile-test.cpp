@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <tile.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(TileTest, CoversImageOnce) {
+  constexpr int width = 100, height = 37;
+  for (TileOrder order :
+       {TileOrder::Scanline, TileOrder::Spiral, TileOrder::Hilbert}) {
+    std::vector<int> covered(width * height, 0);
+    for (const Tile& t : GenerateTiles(width, height, 16, order)) {
+      EXPECT_LE(t.Width(), 16);
+      EXPECT_LE(t.Height(), 16);
+      for (int y = t.y0; y < t.y1; ++y)
+        for (int x = t.x0; x < t.x1; ++x)
+          ++covered[y * width + x];
+    }
+    for (int it : covered)
+      ASSERT_EQ(it, 1) << static_cast<int>(order);
+  }
+}
+
+TEST(TileTest, Orders) {
+  auto scanline = GenerateTiles(64, 64, 16, TileOrder::Scanline);
+  EXPECT_EQ(scanline[1].x0, 16);
+  EXPECT_EQ(scanline[4].y0, 16);
+
+  // the first spiral tiles are the ones around the centre
+  auto spiral = GenerateTiles(80, 80, 16, TileOrder::Spiral);
+  EXPECT_EQ(spiral[0].x0, 32);
+  EXPECT_EQ(spiral[0].y0, 32);
+
+  // consecutive tiles along a Hilbert curve are always neighbours
+  auto hilbert = GenerateTiles(64, 64, 16, TileOrder::Hilbert);
+  for (size_t i = 1; i < hilbert.size(); ++i)
+    EXPECT_EQ(std::abs(hilbert[i].x0 - hilbert[i - 1].x0) +
+                  std::abs(hilbert[i].y0 - hilbert[i - 1].y0),
+              16);
+
+  EXPECT_EQ(ParseTileOrder("hilbert"), TileOrder::Hilbert);
+  EXPECT_THROW(ParseTileOrder("random"), std::runtime_error);
+}
+
+TEST(TileTest, SchedulerHandsOutEachTileOnce) {
+  TileScheduler scheduler(GenerateTiles(256, 256, 8));
+  std::vector<std::atomic<int>> claimed(scheduler.Size());
+  auto worker = [&]() {
+    while (auto tile = scheduler.Next())
+      ++claimed[(tile->y0 / 8) * 32 + tile->x0 / 8];
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back(worker);
+  for (auto& t : threads)
+    t.join();
+
+  for (const auto& it : claimed)
+    EXPECT_EQ(it.load(), 1);
+  EXPECT_FALSE(scheduler.Next().has_value());
+}